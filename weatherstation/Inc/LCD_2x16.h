@@ -33,8 +33,17 @@ extern "C" {
 /* Used for delay in us function ---------------------------------------------*/
 #include "delayus_lib.h"
 
-/* Used for sprintf() --------------------------------------------------------*/
-#include <stdio.h>
+/* Used for fast access to the data, RS and enable pins ----------------------*/
+#include "gpio_lib.h"
+
+/* Used for the I2C backpack transport if LCD_I2C is defined ------------------*/
+#include "lcd_pcf8574.h"
+
+/* Used for cycle counting in benchmark_lcd() --------------------------------*/
+#include "benchmark.h"
+
+/* Used to format the fields of the views -----------------------------------*/
+#include "format_lib.h"
 
 
 /* View_mode represents the currently set mode, for template selection ---------*/
@@ -44,6 +53,8 @@ enum View_mode
 	Temp_and_humidity,			// Temp in first row, humidity in second
 	Time_only,					// Only current Time is shown in first row
 	Temp_humi_and_clock,		// Temp and humidity alternating with Time_only
+	Big_clock,					// HH:MM with big digits over both rows, seconds small
+	Temp_history,				// Temp in first row, sparkline of recent temps in second
 	Time_conf					// Time is shown in first row, has blinking cursor
 };
 
@@ -56,9 +67,23 @@ enum Time_frac_selected
 	None_sel					// cursor is disabled
 };
 
+/* Used to mark the shown temperature depending on the age of the reading -------*/
+enum Temp_state
+{
+	Temp_valid,					// temperature is up to date
+	Temp_stale,					// no new reading for a while, value is marked with '?'
+	Temp_missing				// sensor doesn't answer, dashes are shown instead of a value
+};
+
 /* Public function prototypes ---------------------------------------------------*/
 void init_display();
-void write_to_display(uint16_t humidity, int16_t temperature, RTC_TimeTypeDef gTime, enum View_mode mode, enum Time_frac_selected selected, uint8_t toggle_mode);
+void add_temperature_history(int16_t temperature);
+void get_flush_stats(uint8_t* bytes, uint16_t* us, uint16_t* queue_full);
+void display_start_async(TIM_HandleTypeDef* htim);
+void display_timer_tick();
+uint8_t is_display_idle();
+void benchmark_lcd();
+uint8_t write_to_display(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, enum Time_frac_selected selected, uint8_t toggle_mode);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file           : benchmark.h
+  * @brief          : Header for benchmark.c file.
+  *                   This file contains the headers of the functions used to
+  *                   measure the runtime of code sections in CPU cycles.
+  *                   Results are collected in bench_results and are meant to
+  *                   be inspected with the debugger (live expressions).
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t ----------------------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for BENCHMARK_ENABLED ------------------------------------------------*/
+#include "main.h"
+
+
+/* Bench_id names every code section that is measured -----------------------*/
+enum Bench_id
+{
+	BENCH_TEMP_BLOCKING,		// blocking get_temperature(), whole reading in main loop
+	BENCH_TEMP_ASYNC_MAIN,		// main loop share of an interrupt driven reading
+	BENCH_TEMP_ASYNC_ISR,		// cycles spent in the 1wire timer interrupt per reading
+	BENCH_CRC8_TABLE,			// crc8_table() over 8 scratchpad bytes
+	BENCH_CRC8_NIBBLE,			// crc8_nibble() over 8 scratchpad bytes
+	BENCH_CRC8_BITWISE,			// crc8_bitwise() over 8 scratchpad bytes
+	BENCH_PIN_HAL,				// release and read 1wire pin with HAL_GPIO_WritePin/ReadPin
+	BENCH_PIN_FAST,				// release and read 1wire pin with gpio_set/gpio_read
+	BENCH_LCD_CHAR_HAL,			// put both nibbles of a char on LCD data pins with HAL_GPIO_WritePin
+	BENCH_LCD_CHAR_PINS,		// put both nibbles of a char on LCD data pins, one BSRR store per pin
+	BENCH_LCD_CHAR_TABLE,		// put both nibbles of a char on LCD data pins with BSRR lookup tables
+	BENCH_RENDER_SPRINTF,		// render a view into the frame with sprintf()
+	BENCH_RENDER_FORMAT,		// render a view into the frame with format_lib
+	BENCH_STACK_SPRINTF,		// stack used by rendering with sprintf(), in bytes
+	BENCH_STACK_FORMAT,			// stack used by rendering with format_lib, in bytes
+	BENCH_COUNT					// number of entries, has to be last
+};
+
+/* Bench_result holds the statistics of one measured code section ------------*/
+struct Bench_result
+{
+	uint32_t last;				// cycles of the last measurement
+	uint32_t min;				// fewest cycles measured
+	uint32_t max;				// most cycles measured
+	uint32_t count;				// number of measurements
+};
+
+/* Results of all measured sections, indexed by enum Bench_id ----------------*/
+extern struct Bench_result bench_results[BENCH_COUNT];
+
+/* Public function prototypes ------------------------------------------------*/
+uint32_t bench_cycles();
+void bench_record(enum Bench_id id, uint32_t cycles);
+void bench_stack_paint();
+uint32_t bench_stack_used();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __BENCHMARK_H */
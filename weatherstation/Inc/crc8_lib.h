@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file           : crc8_lib.h
+  * @brief          : Header for crc8_lib.c file.
+  *                   This file contains the headers of the functions used to
+  *                   calculate the Dallas/Maxim CRC8 (x^8 + x^5 + x^4 + 1) of
+  *                   1wire ROM codes and scratchpads.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CRC8_LIB_H
+#define __CRC8_LIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t ----------------------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for CRC8_TABLE and BENCHMARK_ENABLED ---------------------------------*/
+#include "main.h"
+
+/* Used for cycle counting in benchmark_crc8() -------------------------------*/
+#include "benchmark.h"
+
+
+/* Public function prototypes ------------------------------------------------*/
+uint8_t crc8(const uint8_t* data, uint8_t length);
+uint8_t crc8_table(const uint8_t* data, uint8_t length);
+uint8_t crc8_nibble(const uint8_t* data, uint8_t length);
+uint8_t crc8_bitwise(const uint8_t* data, uint8_t length);
+void benchmark_crc8();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __CRC8_LIB_H */
@@ -2,8 +2,9 @@
   ******************************************************************************
   * @file           : delayus_lib.h
   * @brief          : Header for delayus_lib.c file.
-  *                   This file contains the header of the function used to
-  *                   implement a delay in microseconds
+  *                   This file contains the headers of the functions used to
+  *                   implement delays in microseconds with a free running
+  *                   hardware timer (TIM14)
   ******************************************************************************
   *
   * @author			: Felix Lohse & Arne Bruhns
@@ -23,8 +24,38 @@ extern "C" {
 /* Used for types like uint16_t ----------------------------------------------*/
 #include "stm32f0xx_hal.h"
 
+/* Used for BENCHMARK_ENABLED ------------------------------------------------*/
+#include "main.h"
+
+/* Used for cycle counting in benchmark_delay() ------------------------------*/
+#include "benchmark.h"
+
+
+#ifdef BENCHMARK_ENABLED
+/* Number of delays measured by benchmark_delay() ----------------------------*/
+#define DELAY_BENCH_COUNT	12
+
+/* Delay_result holds requested and actual delay of one measured value -------*/
+struct Delay_result
+{
+	uint16_t requested;			// argument of delayUs() in us
+	uint32_t min_ns;			// shortest delay measured in ns
+	uint32_t max_ns;			// longest delay measured in ns
+};
+
+/* Results of benchmark_delay() ----------------------------------------------*/
+extern struct Delay_result delay_results[DELAY_BENCH_COUNT];
+#endif
+
 /* Public function prototypes ------------------------------------------------*/
+void delay_init();
+uint16_t delay_now();
+uint16_t delay_elapsed_us(uint16_t start);
 void delayUs(uint16_t us);
+uint16_t delay_deadline(uint16_t us);
+uint8_t delay_expired(uint16_t deadline);
+void delay_until(uint16_t deadline);
+void benchmark_delay();
 
 
 #ifdef __cplusplus
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file           : event_queue.h
+  * @brief          : Header for event_queue.c file.
+  *                   This file contains the headers of the functions used to
+  *                   pass timestamped events from the interrupts to the main
+  *                   loop. The queue has one producer, the interrupts posting
+  *                   to it have to share one priority, and one consumer, the
+  *                   main loop. It needs neither locks nor disabled interrupts.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __EVENT_QUEUE_H
+#define __EVENT_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and __DMB() ----------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for EVENT_QUEUE_SIZE, TRUE and FALSE ---------------------------------*/
+#include "main.h"
+
+#if (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) || EVENT_QUEUE_SIZE > 128
+#error "EVENT_QUEUE_SIZE has to be a power of two up to 128"
+#endif
+
+
+/* Event_type tells the interrupt an event comes from ------------------------*/
+enum Event_type {Event_humidity};
+
+/* Event is one entry of the queue -------------------------------------------*/
+struct Event
+{
+	uint32_t time_us;			// scheduler_now_us() when posted
+	uint16_t data;				// depends on type, the ADC value for Event_humidity
+	uint8_t type;				// one of enum Event_type
+};
+
+/* Event_stats holds the fill level statistics of the queue ------------------*/
+struct Event_stats
+{
+	uint32_t posted;			// events posted, including dropped ones
+	uint16_t overflows;			// events dropped because the queue was full
+	uint8_t high_water;			// most events in the queue at once
+	uint32_t max_wait_us;		// longest time from posting till fetching
+};
+
+/* Statistics of the queue ---------------------------------------------------*/
+extern struct Event_stats event_stats;
+
+/* Public function prototypes ------------------------------------------------*/
+uint8_t event_post(enum Event_type type, uint16_t data);
+uint8_t event_get(struct Event* event);
+uint8_t event_pending();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __EVENT_QUEUE_H */
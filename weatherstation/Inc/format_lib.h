@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file           : format_lib.h
+  * @brief          : Header for format_lib.c file.
+  *                   This file contains the headers of the functions used to
+  *                   format the fields shown on the display without sprintf().
+  *                   All functions write into a given buffer without
+  *                   terminating zero and return the position behind the field.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FORMAT_LIB_H
+#define __FORMAT_LIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t ----------------------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Degree sign in the ROM character set of the HD44780 -----------------------*/
+#define DEGREE_SIGN			'\xDF'
+
+
+/* Public function prototypes ------------------------------------------------*/
+char* format_text(char* dst, const char* text);
+char* format_uint(char* dst, uint16_t value);
+char* format_2digits(char* dst, uint8_t value);
+char* format_time(char* dst, uint8_t hours, uint8_t minutes, uint8_t seconds);
+char* format_temperature(char* dst, int16_t temperature);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FORMAT_LIB_H */
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file           : gpio_lib.h
+  * @brief          : Header only GPIO access for the bit banged drivers.
+  *                   Replaces HAL_GPIO_WritePin() and HAL_GPIO_ReadPin() in
+  *                   timing critical code. With constant port and pins every
+  *                   write compiles to one store to BSRR or BRR and every read
+  *                   to one load of IDR, no function call is left.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __GPIO_LIB_H
+#define __GPIO_LIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for GPIO_TypeDef and types like uint16_t -----------------------------*/
+#include "stm32f0xx_hal.h"
+
+
+/**
+  * @brief Sets pins of a port to high (released for open drain pins).
+  * @param GPIO_TypeDef* port GPIO port, e.g. OneWire_DS1820_GPIO_Port
+  * @param uint16_t pins pins to set, several can be combined
+  * @retval None
+  */
+static inline void gpio_set(GPIO_TypeDef* port, uint16_t pins) {
+	port->BSRR = pins;
+}
+
+/**
+  * @brief Sets pins of a port to low.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint16_t pins pins to reset, several can be combined
+  * @retval None
+  */
+static inline void gpio_reset(GPIO_TypeDef* port, uint16_t pins) {
+	port->BRR = pins;
+}
+
+/**
+  * @brief Sets pins of a port to the given state.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint16_t pins pins to write, several can be combined
+  * @param uint8_t state 0 for low, high otherwise
+  * @retval None
+  */
+static inline void gpio_write(GPIO_TypeDef* port, uint16_t pins, uint8_t state) {
+	port->BSRR = (state ? (uint32_t) pins : (uint32_t) pins << 16);
+}
+
+/**
+  * @brief Sets some pins of a port to high and others to low at the same time.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint16_t high pins to set
+  * @param uint16_t low pins to reset, high wins if a pin is in both
+  * @retval None
+  */
+static inline void gpio_write_mask(GPIO_TypeDef* port, uint16_t high, uint16_t low) {
+	port->BSRR = (uint32_t) low << 16 | high;
+}
+
+/**
+  * @brief Writes a precomputed BSRR word, pins in the lower half are set, pins
+  * 	   in the upper half are reset.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint32_t bsrr set and reset bits
+  * @retval None
+  */
+static inline void gpio_write_bsrr(GPIO_TypeDef* port, uint32_t bsrr) {
+	port->BSRR = bsrr;
+}
+
+/**
+  * @brief Switches pins of a port to input or output. Slow compared to the
+  * 	   other functions, loops over the pins.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint16_t pins pins to switch, several can be combined
+  * @param uint32_t mode GPIO_MODE_INPUT or GPIO_MODE_OUTPUT_PP
+  * @retval None
+  */
+static inline void gpio_mode(GPIO_TypeDef* port, uint16_t pins, uint32_t mode) {
+	uint32_t mask = 0;
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < 16; i++) {
+		if (!(pins >> i & 1)) continue;
+		mask |= 3U << (2 * i);
+		value |= mode << (2 * i);
+	}
+	port->MODER = (port->MODER & ~mask) | value;
+}
+
+/**
+  * @brief Reads pins of a port.
+  * @param GPIO_TypeDef* port GPIO port
+  * @param uint16_t pins pins to read, several can be combined
+  * @retval uint16_t pins that are high
+  */
+static inline uint16_t gpio_read(GPIO_TypeDef* port, uint16_t pins) {
+	return port->IDR & pins;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __GPIO_LIB_H */
@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file           : keypad.h
+  * @brief          : Header for keypad.c file.
+  *                   This file contains the headers of the functions used to
+  *                   scan and debounce the 4x4 keypad. Every scan reads the
+  *                   rows of one column, the events of a key are handed to the
+  *                   handler given to keypad_init() right away. Event counts
+  *                   and the key to display latency are collected in
+  *                   keypad_stats and are meant to be inspected with the
+  *                   debugger.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KEYPAD_H
+#define __KEYPAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and GPIO_TypeDef -----------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for the pins, KEYPAD_DEBOUNCE, TRUE and FALSE ------------------------*/
+#include "main.h"
+
+#if KEYPAD_LONG + KEYPAD_REPEAT > 255
+#error "KEYPAD_LONG + KEYPAD_REPEAT have to fit into a byte"
+#endif
+
+
+/* Number of keys, keys are numbered row by row ------------------------------*/
+#define KEYPAD_KEYS			16
+
+/* Number of a key from its row and column and back --------------------------*/
+#define KEY(row, col)		((row) << 2 | (col))
+#define KEY_ROW(key)		((key) >> 2)
+#define KEY_COL(key)		((key) & 0x03)
+
+/* Key_event is what happened to a key ---------------------------------------*/
+enum Key_event {Key_press, Key_release, Key_long, Key_repeat, Key_events};
+
+/* Keypad_stats holds the event counts and latencies of the keypad -----------*/
+struct Keypad_stats
+{
+	uint16_t events[Key_events];	// number of events of each kind
+	uint16_t bounces;				// changes that didn't last KEYPAD_DEBOUNCE scans
+	uint32_t last_latency_us;		// time from the first scan reading the last press till it was shown
+	uint32_t max_latency_us;		// longest of these times
+};
+
+/* Event counts and latencies ------------------------------------------------*/
+extern struct Keypad_stats keypad_stats;
+
+/* Public function prototypes ------------------------------------------------*/
+void keypad_init(void (*handler)(uint8_t key, enum Key_event event));
+uint8_t keypad_scan();
+uint8_t keypad_idle();
+void keypad_shown();
+void keypad_park();
+void keypad_resume();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KEYPAD_H */
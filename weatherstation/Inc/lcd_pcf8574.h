@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file           : lcd_pcf8574.h
+  * @brief          : Header for lcd_pcf8574.c file.
+  *                   This file contains the headers of the functions used to
+  *                   drive the display through a PCF8574 I2C expander backpack.
+  *                   Bytes for the display are batched and moved by DMA.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LCD_PCF8574_H
+#define __LCD_PCF8574_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and I2C_HandleTypeDef ------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for LCD_I2C, LCD_ROWS and LCD_COLS -----------------------------------*/
+#include "main.h"
+
+#if LCD_I2C_SPEED > 100000
+#error "LCD_I2C_SPEED can't be above 100 kHz, the PCF8574 doesn't allow more"
+#endif
+
+/* Public function prototypes ------------------------------------------------*/
+void lcd_i2c_init(I2C_HandleTypeDef* hi2c);
+void lcd_i2c_write(uint8_t byte, uint8_t data);
+uint8_t lcd_i2c_queue(uint8_t byte, uint8_t data, uint8_t clear);
+uint8_t lcd_i2c_room();
+void lcd_i2c_send();
+uint8_t lcd_i2c_idle();
+void lcd_i2c_transfer_complete(uint8_t error);
+uint8_t lcd_i2c_failed();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __LCD_PCF8574_H */
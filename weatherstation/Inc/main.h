@@ -105,8 +105,56 @@ void Error_Handler(void);
 #define DB4_Pin GPIO_PIN_5
 #define DB4_GPIO_Port GPIOB
 /* USER CODE BEGIN Private defines */
+/*
+ * Pins of all 1wire buses, first one is used if the device table is empty.
+ * All have to be on OneWire_DS1820_GPIO_Port, e.g. {OneWire_DS1820_Pin, GPIO_PIN_5}.
+ */
+#define ONEWIRE_BUS_PINS	{OneWire_DS1820_Pin}
+
 #define FALSE 0				// used for better readability in boolean context
 #define TRUE !FALSE
+
+//#define BENCHMARK_ENABLED			// uncomment to measure runtimes, results in bench_results
+
+#define SCHEDULER_MAX_TASKS	8		// size of the task table, 44 bytes RAM per entry
+#define SCHEDULER_STAGGER			// comment out to release tasks with the same period on the same tick
+#define EVENT_QUEUE_SIZE	16		// events from the interrupts to the main loop, power of two, 8 bytes RAM per entry
+
+#define KEYPAD_DEBOUNCE		2		// scans a key has to read the same to count, a scan of all columns takes 4 TIM6 ticks
+#define KEYPAD_LONG			40		// scans a key is held till Key_long, ~1 s
+#define KEYPAD_REPEAT		8		// scans between two Key_repeat after Key_long, ~200 ms
+
+#define IDLE_SLEEP					// comment out to spin the main loop instead of Sleep mode while a peripheral is busy, TIM6 ticks wake it
+#define IDLE_STOP					// comment out while debugging, Stop mode disconnects the debugger. Only Stop mode is tickless
+
+#define ONEWIRE_MAX_DEVICES	8		// size of the 1wire device table, 18 bytes RAM per entry
+//#define CRC8_TABLE					// uncomment for 256 byte CRC8 table, default 32 byte nibble tables
+#define ONEWIRE_CHECK_CRC			// comment out to skip the CRC byte, scratchpad reads are truncated then
+#define ONEWIRE_EXTENDED_RESOLUTION	// comment out for 0.5 degC resolution, reads 2 instead of 8 bytes
+#define ONEWIRE_RESOLUTION	11		// DS18B20 resolution in bits, 11 bit converts in 375 ms
+//#define ONEWIRE_UART				// uncomment to run 1wire on USART2 TX (PA2) with DMA instead of OneWire_DS1820 pin
+//#define ONEWIRE_ALARM_WINDOW	1	// uncomment to read only devices that left a TH/TL window of +-1 degC
+
+/* Size of the display, HD44780 with 2x16 up to 4x20 or 2x40 cells */
+#define LCD_ROWS			2
+#define LCD_COLS			16
+
+/* Uncomment if DB0-DB3 of the display are wired, a byte is sent with one enable pulse then */
+//#define LCD_8BIT
+//#define DB0_Pin GPIO_PIN_12		// DB0-DB3 have to be on one port
+//#define DB1_Pin GPIO_PIN_13
+//#define DB2_Pin GPIO_PIN_14
+//#define DB3_Pin GPIO_PIN_15
+//#define DB0_GPIO_Port GPIOB
+
+/* Uncomment if the display is connected by a PCF8574 backpack to I2C1 (PB8 SCL, PB9 SDA) */
+//#define LCD_I2C
+#define LCD_I2C_ADDRESS		0x27		// 7 bit address, 0x3F for PCF8574A
+#define LCD_I2C_SPEED		100000		// in Hz, has to match the Timing of I2C1, the PCF8574 allows 100 kHz at most
+
+/* Uncomment if R/W of the display is wired, the busy flag is polled then instead of fixed delays */
+//#define LCD_RW_Pin GPIO_PIN_6
+//#define LCD_RW_GPIO_Port GPIOB
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
@@ -26,14 +26,57 @@ extern "C" {
 /* Used for GPIO Ports and Pins ----------------------------------------------*/
 #include "main.h"
 
+/* Used for fast access to the bus pins ---------------------------------------*/
+#include "gpio_lib.h"
+
 /* Used for delay in us function ---------------------------------------------*/
 #include "delayus_lib.h"
 
+/* Used for 1wire over USART, if ONEWIRE_UART is defined ---------------------*/
+#include "onewire_uart.h"
+
+/* Used for scratchpad and ROM verification ----------------------------------*/
+#include "crc8_lib.h"
+
+/* Used for cycle counting in benchmark_temperature_reading() ----------------*/
+#include "benchmark.h"
+
+
+/* Returned by get_temperature() if the DS1820 didn't answer -----------------*/
+#define TEMPERATURE_INVALID		((int16_t)0x8000)
 
 /* Public function prototypes ------------------------------------------------*/
 int16_t get_temperature();
 uint8_t get_presence();
 
+/* Device table for multiple DS1820 on the bus -------------------------------*/
+uint8_t search_devices();
+uint8_t get_device_count();
+uint8_t get_device_temperature(uint8_t index, int16_t* temperature);
+void get_device_errors(uint8_t index, uint16_t* crc_errors, uint16_t* retries);
+uint8_t read_device_scratchpad(uint8_t index, uint8_t* scratchpad);
+uint8_t write_device_scratchpad(uint8_t index, uint8_t th, uint8_t tl, uint8_t config);
+uint8_t set_resolution(uint8_t bits);
+uint8_t set_alarm(uint8_t index, int8_t th, int8_t tl);
+
+/* Interrupt driven reading, timer has to tick with 1 MHz --------------------*/
+void onewire_init(TIM_HandleTypeDef* htim);
+void onewire_timer_tick();
+void onewire_transfer_complete();
+uint8_t start_temperature(void (*callback)(int16_t temperature, uint8_t valid));
+uint8_t poll_temperature();
+uint8_t complete_temperature(int16_t* temperature);
+uint8_t start_temperature_pipelined(void (*callback)(int16_t temperature, uint8_t valid));
+uint32_t get_temperature_age();
+uint8_t is_sensor_present();
+uint8_t is_device_present(uint8_t index);
+uint8_t is_onewire_idle();
+uint8_t onewire_hotplug_poll();
+int32_t get_bus_time_saved();
+int32_t get_transactions_saved();
+void benchmark_temperature_reading();
+void benchmark_pin_access();
+
 
 #ifdef __cplusplus
 }
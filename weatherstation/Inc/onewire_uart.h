@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file           : onewire_uart.h
+  * @brief          : Header for onewire_uart.c file.
+  *                   This file contains the headers of the functions used to
+  *                   generate 1wire slots with a USART in single wire half
+  *                   duplex mode. Every 1wire bit is one UART byte, transfers
+  *                   are moved by DMA.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ONEWIRE_UART_H
+#define __ONEWIRE_UART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and UART_HandleTypeDef -----------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for ONEWIRE_UART -----------------------------------------------------*/
+#include "main.h"
+
+
+/* Public function prototypes ------------------------------------------------*/
+void onewire_uart_init(UART_HandleTypeDef* huart);
+uint8_t onewire_uart_reset();
+uint8_t onewire_uart_bit(uint8_t bit);
+void onewire_uart_start_reset();
+uint8_t onewire_uart_presence();
+void onewire_uart_start_bits(const uint8_t* bytes, uint8_t bits);
+void onewire_uart_get_bits(uint8_t* bytes, uint8_t bits);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __ONEWIRE_UART_H */
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file           : power.h
+  * @brief          : Header for power.c file.
+  *                   This file contains the headers of the functions used to
+  *                   idle the core between the tasks of the main loop. Sleep
+  *                   mode is left by the next interrupt, Stop mode by an RTC
+  *                   alarm at the next release or a key press. The duty cycle
+  *                   and the estimated current are collected in power_stats
+  *                   and are meant to be inspected with the debugger.
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __POWER_H
+#define __POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and RTC_HandleTypeDef ------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for IDLE_SLEEP, IDLE_STOP, TRUE and FALSE ----------------------------*/
+#include "main.h"
+
+
+/*
+ * Typical supply currents of the STM32F030x8 in uA, 48 MHz from HSI and PLL
+ * with the peripherals enabled, Stop with the regulator in low power mode and
+ * the RTC running on LSE. Approximate datasheet values, display and sensors
+ * aren't included, so the estimates are for the MCU only.
+ */
+#define IDD_RUN_UA			22000
+#define IDD_SLEEP_UA		14000
+#define IDD_STOP_UA			20
+
+/*
+ * Shortest idle time Stop mode is entered for. The alarm has a resolution of
+ * one RTC subsecond (3.9 ms), the PLL needs ~200 us to lock again after waking.
+ */
+#define POWER_STOP_MIN_US	10000
+
+/* Length of the window power_stats are computed for ------------------------*/
+#define POWER_WINDOW		1000			// in ms, at most 4000
+
+/* Power_mode is the state the core spends its idle time in ------------------*/
+enum Power_mode {Power_run, Power_sleep, Power_stop, Power_modes};
+
+/* Power_stats holds the duty cycle and current estimates of the last window -*/
+struct Power_stats
+{
+	uint16_t duty_permille;				// time running in 1/1000 of the window
+	uint16_t sleep_permille;			// time in Sleep mode
+	uint16_t stop_permille;				// time in Stop mode
+	uint16_t entries[Power_modes];		// Sleep and Stop mode entries, idle calls that kept running
+	uint32_t current_ua[Power_modes];	// estimated current if all idle time was spent in the mode
+	uint32_t average_ua;				// estimated current with the modes actually used
+};
+
+/* Duty cycle and currents of the last window --------------------------------*/
+extern struct Power_stats power_stats;
+
+/* Public function prototypes ------------------------------------------------*/
+void power_init(RTC_HandleTypeDef* hrtc, void (*stop_enter)(), void (*stop_exit)());
+enum Power_mode power_idle(uint32_t sleep_us, uint32_t stop_us);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __POWER_H */
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file           : scheduler.h
+  * @brief          : Header for scheduler.c file.
+  *                   This file contains the headers of the functions used to
+  *                   run periodic tasks from a task table in the main loop.
+  *                   The timer interrupt only counts ticks, tasks run to
+  *                   completion in table order. Overruns and worst case
+  *                   latencies are collected in task_stats and are meant to
+  *                   be inspected with the debugger (live expressions).
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Used for types like uint16_t and TIM_HandleTypeDef ------------------------*/
+#include "stm32f0xx_hal.h"
+
+/* Used for SCHEDULER_MAX_TASKS, TRUE and FALSE ------------------------------*/
+#include "main.h"
+
+
+/* Phase of tasks that are spread evenly over their period by scheduler_init() */
+#define PHASE_AUTO			0xFFFF
+
+/* Buckets of the latency histogram, bucket 0 < 128 us, each next one doubles --*/
+#define JITTER_BUCKETS		8
+#define JITTER_FIRST_SHIFT	7			// bucket 0 holds latencies below 1 << JITTER_FIRST_SHIFT us
+
+/* Task is one entry of the task table, all times are in timer ticks ---------*/
+struct Task
+{
+	uint8_t (*run)();			// returns TRUE when done, FALSE to be called again by the next scheduler_run()
+	uint16_t period;			// ticks between two releases
+	uint16_t phase;				// ticks from scheduler_init() till the first release, or PHASE_AUTO
+	uint16_t deadline;			// ticks after its release the task has to be done
+};
+
+/* Task_stats holds the timing statistics of one task -------------------------*/
+struct Task_stats
+{
+	uint32_t released;			// number of releases
+	uint16_t overruns;			// releases while the last one wasn't done yet
+	uint16_t deadline_misses;	// releases done after their deadline
+	uint32_t max_latency_us;	// longest time from release to first start
+	uint32_t max_response_us;	// longest time from release to done
+	uint16_t jitter[JITTER_BUCKETS];	// number of releases per latency bucket, bucket 7 >= 8 ms
+};
+
+/* Statistics of all tasks, indexed like the task table ----------------------*/
+extern struct Task_stats task_stats[SCHEDULER_MAX_TASKS];
+
+/* Public function prototypes ------------------------------------------------*/
+void scheduler_init(TIM_HandleTypeDef* htim, const struct Task* table, uint8_t count);
+void scheduler_tick();
+void scheduler_run();
+void scheduler_trigger(uint8_t (*run)());
+uint32_t scheduler_now_us();
+uint32_t scheduler_idle_us(uint16_t min_period);
+void scheduler_advance(uint32_t us);
+void scheduler_reset_stats();
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SCHEDULER_H */
@@ -12,10 +12,16 @@
 
 #include "LCD_2x16.h"
 
+#ifdef BENCHMARK_ENABLED
+/* Used for sprintf() in the reference of benchmark_lcd() ----------------------*/
+#include <stdio.h>
+#endif
+
 /* Instructions for the display --------------------------------------------------*/
 #define LCD_8BIT_MODE 		0x30
 #define LCD_4BIT_MODE 		0x20
 #define LCD_TWOLINES_5_8  	0x28
+#define LCD_8BIT_TWOLINES_5_8	0x38
 #define DISPLAY_OFF	  		0x04
 #define CLEAR_DISPLAY 		0x01
 #define DISPLAY_ON	  		0x0C
@@ -24,40 +30,276 @@
 #define CURSOR_OFF_BLINKING	0x0D
 #define CURSOR_OFF			0x0C
 #define HOME				0x02
-#define SET_CURSOR_SEC_LINE 0xC0
-#define SET_CURSOR_HOURS	0x85
-#define SET_CURSOR_MINS		0x88
-#define SET_CURSOR_SECS		0x8B
+#define SET_DDRAM_ADDRESS	0x80		// | address, first row starts at 0x00
+#define SET_CGRAM_ADDRESS	0x40		// | address, 8 bytes per glyph
+#define SET_CURSOR_HOURS	(SET_DDRAM_ADDRESS | (ROW_ADDRESS(0) + TIME_COL + 1))
+#define SET_CURSOR_MINS		(SET_DDRAM_ADDRESS | (ROW_ADDRESS(0) + TIME_COL + 4))
+#define SET_CURSOR_SECS		(SET_DDRAM_ADDRESS | (ROW_ADDRESS(0) + TIME_COL + 7))
+
+/* Size of the display, LCD_ROWS and LCD_COLS are set in main.h -------------------*/
+#if LCD_ROWS < 2 || LCD_COLS < 16
+#error "views need a display of at least 2x16 cells"
+#endif
+#if LCD_ROWS > 4 || LCD_ROWS * LCD_COLS > 80
+#error "HD44780 has 80 cells of DDRAM, 4 rows at most"
+#endif
+#if defined(LCD_I2C) && (defined(LCD_8BIT) || defined(LCD_RW_Pin))
+#error "PCF8574 backpack drives the display in 4 bit mode without busy flag"
+#endif
+
+/*
+ * DDRAM addresses in 2 line mode. Rows 0 and 1 start at 0x00 and 0x40, rows
+ * 2 and 3 of a 4 row display continue them after LCD_COLS cells. After 0x27 the
+ * address counter jumps to 0x40, after 0x67 back to 0x00.
+ */
+#define ROW_ADDRESS(row)	(((row) & 1) * 0x40 + ((row) >> 1) * LCD_COLS)
+#define NEXT_ADDRESS(a)		((a) == 0x27 ? 0x40 : (a) == 0x67 ? 0x00 : (a) + 1)
+#define NO_ADDRESS			0xFF		// address counter is unknown
+#define CGRAM				0x80		// lcd_address points into CGRAM, | CGRAM address
+
+/* Custom glyphs, shown by the char codes GLYPH(0) to GLYPH(7) ----------------------*/
+#define GLYPHS				8
+#define GLYPH_ROWS			8
+#define GLYPH(slot)			(0x08 + (slot))		// same glyphs as codes 0-7, avoids 0 in the frame
+#define FULL_BLOCK			'\xFF'				// ROM char
+#define MIDDLE_DOT			'\xA5'				// ROM char, used as colon of the big clock
+
+/* Big digit glyphs, 3 * 2 cells per digit --------------------------------------*/
+#define LT					GLYPH(0)	// left top corner
+#define UB					GLYPH(1)	// upper bar
+#define RT					GLYPH(2)	// right top corner
+#define LL					GLYPH(3)	// left lower corner
+#define LB					GLYPH(4)	// lower bar
+#define LR					GLYPH(5)	// right lower corner
+#define UMB					GLYPH(6)	// upper and middle bar
+#define LMB					GLYPH(7)	// lower and middle bar
+#define BIG_DIGIT_WIDTH		3
+
+/* Columns of the big clock, seconds are shown small in the second row -----------*/
+#define BIG_HOURS_COL		(VIEW_COL + 0)
+#define BIG_COLON_COL		(VIEW_COL + 6)
+#define BIG_MINUTES_COL		(VIEW_COL + 7)
+#define BIG_SECONDS_COL		(VIEW_COL + 14)
+
+/* Temperature history of the sparkline ------------------------------------------*/
+#define HISTORY_LENGTH		8			// samples, one cell each
+#define SPARKLINE_COL		(VIEW_COL + 4)
+
+/* Worst case execution times, waited if the busy flag can't be read ------------*/
+#define EXECUTION_TIME		50			// most instructions and data, in us
+#define CLEAR_TIME			2			// CLEAR_DISPLAY and HOME, in ms
+
+/* Busy flag is polled at most this long, then the fixed delays are used -------*/
+#define BUSY_TIMEOUT		3000		// in us
+
+/* Queue of bytes sent by the timer interrupt, size has to be a power of 2 -------*/
+#if LCD_ROWS * LCD_COLS > 48
+#define QUEUE_SIZE			128			// whole frame with address jumps and cursor fits
+#else
+#define QUEUE_SIZE			64
+#endif
+#define QUEUE_DATA			0x100		// entry is data, RS high
+#define QUEUE_CLEAR			0x200		// entry is CLEAR_DISPLAY or HOME, waits CLEAR_TIME
+
+/* Time between both nibbles of a byte in the timer interrupt --------------------*/
+#define NIBBLE_TIME			2			// in us, enable cycle time is 1 us
+
+/* Characters written per measurement of the throughput in benchmark_lcd() ------*/
+#define LCD_BENCH_CHARS		LCD_COLS
+
+/* Number of calls per measurement in benchmark_lcd() -------------------------*/
+#define LCD_BENCH_CALLS		100
+
+/* Columns of the fields in the rows, views are centered on wider displays ------*/
+#define VIEW_COL			((LCD_COLS - 16) / 2)
+#define TIME_COL			(VIEW_COL + 4)		// time in the first row
+#define TIME_COL_SECOND		(LCD_COLS - 8)		// time right aligned in the second row
+#define TEMP_COL			(VIEW_COL + 4)
+#define HUMIDITY_COL		(VIEW_COL + 7)
+
+/*
+ * BSRR words that put a nibble on the data pins. DB4-DB6 are on DB4_GPIO_Port
+ * (GPIOB), DB7 on DB7_GPIO_Port (GPIOA), so a nibble is two stores.
+ * Each word sets the pins of the 1 bits and resets the pins of the 0 bits.
+ */
+#define BSRR_BIT(n, bit, pin)	(((n) >> (bit) & 1) ? (uint32_t) (pin) : (uint32_t) (pin) << 16)
+#define BSRR_DB4_DB6(n)			(BSRR_BIT(n, 0, DB4_Pin) | BSRR_BIT(n, 1, DB5_Pin) | BSRR_BIT(n, 2, DB6_Pin))
+#define BSRR_DB7(n)				BSRR_BIT(n, 3, DB7_Pin)
+#define NIBBLE_TABLE(f)			{f(0), f(1), f(2), f(3), f(4), f(5), f(6), f(7), \
+								 f(8), f(9), f(10), f(11), f(12), f(13), f(14), f(15)}
+
+/* In 8 bit mode the low nibble goes to DB0-DB3, all on DB0_GPIO_Port ------------*/
+#define BSRR_DB0_DB3(n)			(BSRR_BIT(n, 0, DB0_Pin) | BSRR_BIT(n, 1, DB1_Pin) | \
+								 BSRR_BIT(n, 2, DB2_Pin) | BSRR_BIT(n, 3, DB3_Pin))
+#define DB0_DB3_Pins			(DB0_Pin | DB1_Pin | DB2_Pin | DB3_Pin)
 
 
-/* String literals that represent the formats for creating the output on rows --*/
+/* Shown instead of the temperature if the sensor doesn't answer ----------------*/
+static const char* const temp_missing = "--.-""\xDF""C";
+
+/* Glyph sets that can be loaded into CGRAM ----------------------------------------*/
+enum Glyph_set
+{
+	Glyphs_none,				// CGRAM content unknown
+	Glyphs_big_digits,			// segments of the big digits
+	Glyphs_bars					// bars of height 1 to 8 for the sparkline
+};
+
+/* Rows of the glyphs, 5 pixels per row in the lower bits --------------------------*/
+static const uint8_t big_digit_glyphs[GLYPHS][GLYPH_ROWS] = {
+	{0x07, 0x0F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},	// LT
+	{0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00},	// UB
+	{0x1C, 0x1E, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},	// RT
+	{0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x0F, 0x07},	// LL
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},	// LB
+	{0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1E, 0x1C},	// LR
+	{0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x1F, 0x1F},	// UMB
+	{0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F}	// LMB
+};
+static const uint8_t bar_glyphs[GLYPHS][GLYPH_ROWS] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}
+};
+
+/* Cells of the big digits 0-9, upper row then lower row -----------------------*/
+static const char big_digits[10][2 * BIG_DIGIT_WIDTH] = {
+	{LT, UB, RT, LL, LB, LR},
+	{UB, RT, ' ', LB, FULL_BLOCK, LB},
+	{UMB, UMB, RT, LL, LB, LB},
+	{UMB, UMB, RT, LB, LB, LR},
+	{LL, LB, FULL_BLOCK, ' ', ' ', FULL_BLOCK},
+	{LL, UMB, UMB, LB, LB, LR},
+	{LT, UMB, UMB, LL, LB, LR},
+	{UB, UB, RT, ' ', ' ', FULL_BLOCK},
+	{LT, UMB, RT, LL, LB, LR},
+	{LT, UMB, RT, LMB, LB, LR}
+};
+
+#ifdef BENCHMARK_ENABLED
+/* Formats of the rows with sprintf(), only used as reference by benchmark_lcd() */
 static const char* const time_only_first_row = "    %02d:%02d:%02d    ";
 static const char* const time_second_row = "        %02d:%02d:%02d";
 static const char* const empty_row = "                 ";
 static const char* const temp_row = "    %s%d.%d""\xDF""C     ";
+static const char* const temp_stale_row = "    %s%d.%d""\xDF""C?    ";
+static const char* const temp_missing_row = "    --.-""\xDF""C     ";
 static const char* const humidity_row = "       %d%%       "; // double % for escaping
+#endif
+
+/* BSRR words per nibble for both data ports, in flash -------------------------*/
+static const uint32_t nibble_db4_db6[16] = NIBBLE_TABLE(BSRR_DB4_DB6);
+#ifdef LCD_8BIT
+static const uint32_t nibble_db0_db3[16] = NIBBLE_TABLE(BSRR_DB0_DB3);
+#endif
+static const uint32_t nibble_db7[16] = NIBBLE_TABLE(BSRR_DB7);
+
+/*
+ * Views render into frame, flush_display() sends only the cells that differ
+ * from screen, the copy of what the display shows.
+ */
+char frame[LCD_ROWS][LCD_COLS];
+char screen[LCD_ROWS][LCD_COLS];
+uint8_t lcd_address = NO_ADDRESS;				// DDRAM address the next data byte goes to
+uint8_t lcd_cursor = CURSOR_OFF;				// last cursor mode instruction sent
+uint8_t lcd_cursor_position = 0;				// SET_CURSOR_* instruction of blinking cursor, 0 if none
+uint8_t lcd_flush_bytes = 0;					// bytes sent by the last flush
+uint16_t lcd_flush_us = 0;						// duration of the last flush in us
+uint8_t cgram[GLYPHS][GLYPH_ROWS];				// copy of the glyphs in CGRAM
+enum Glyph_set glyph_set = Glyphs_none;			// glyph set completely loaded into CGRAM
+int16_t history[HISTORY_LENGTH];				// temperature samples of the sparkline, oldest first
+uint8_t history_count = 0;						// valid samples in history
+uint8_t lcd_busy_flag = FALSE;					// TRUE if the busy flag is polled instead of fixed delays
+uint16_t lcd_busy_timeouts = 0;					// busy flag polls that timed out
+TIM_HandleTypeDef* lcd_htim = NULL;				// timer draining the queue, NULL while sending blocking
+uint16_t lcd_queue[QUEUE_SIZE];					// bytes with QUEUE_DATA and QUEUE_CLEAR flags
+volatile uint8_t lcd_queue_head = 0;			// next free entry, written by main loop
+volatile uint8_t lcd_queue_tail = 0;			// next entry to send, written by timer interrupt
+volatile uint8_t lcd_sending = FALSE;			// TRUE while the timer interrupt drains the queue
+uint8_t lcd_nibble = 0;							// 0 high nibble of the tail entry is next, 1 low nibble
+uint16_t lcd_queue_full = 0;					// updates that didn't fit into the queue
+#ifdef BENCHMARK_ENABLED
+uint32_t lcd_chars_per_second[2];				// throughput with fixed delays and with busy flag
+#endif
 
 /* Private prototypes ----------------------------------------------------------*/
+void render_view(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, uint8_t toggle_mode);
+void render_time(uint8_t row, uint8_t col, RTC_TimeTypeDef gTime);
+void render_temperature(uint8_t row, int16_t temperature, enum Temp_state temp_state);
+void render_humidity(uint8_t row, uint16_t humidity);
+void render_big_clock(RTC_TimeTypeDef gTime);
+void render_sparkline(uint8_t row);
+uint8_t queue_room();
+uint8_t upload_glyph(uint8_t slot, const uint8_t* rows);
+uint8_t load_glyph_set(enum Glyph_set set);
+#ifdef BENCHMARK_ENABLED
+void render_row(uint8_t row, const char* text);
+void render_view_sprintf(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, uint8_t toggle_mode);
+#endif
+uint8_t flush_display(uint8_t cursor, uint8_t position);
+uint8_t flush_length();
+void set_nibble(uint8_t nibble);
+void set_data_pins_mode(uint32_t mode);
 void send_byte_to_lcd(uint8_t byte);
-void send_instruction(uint8_t byte);
-void send_data(uint8_t byte);
+uint8_t send_instruction(uint8_t byte);
+uint8_t send_data(uint8_t byte);
 void setRSInstruction();
 void setRSData();
 void send_enable_pulse();
+uint8_t read_busy_flag();
+void wait_ready(uint8_t byte, uint8_t instruction);
+uint8_t enqueue(uint16_t entry);
+void arm_display_timer(uint16_t time);
+#ifdef LCD_I2C
+void forget_display();
+#endif
 
 /* -----------------------------------------------------------------------------*/
 
-/* Arrays to iterate while while sending data/instruction --------------------- */
+#ifdef BENCHMARK_ENABLED
+/* Arrays to iterate while sending, only used by set_nibble_hal() ------------- */
 uint16_t LCD_PINS[4] = {DB4_Pin, DB5_Pin, DB6_Pin, DB7_Pin};
 GPIO_TypeDef* LCD_PORTS[4] = {DB4_GPIO_Port, DB5_GPIO_Port, DB6_GPIO_Port, DB7_GPIO_Port};
 
+/**
+  * @brief Puts a nibble on DB4-DB7 with the HAL, like the driver did before
+  * 	   gpio_lib.h. Only compiled as reference for benchmark_lcd().
+  * @param uint8_t nibble bits to put on DB4-DB7
+  * @retval None
+  */
+void set_nibble_hal(uint8_t nibble) {
+	for (uint8_t i = 0; i < 4; i++ ) {
+		if (nibble >> i & 1) HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_SET);
+		else HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_RESET);
+	}
+}
+
+/**
+  * @brief Puts a nibble on DB4-DB7 with one BSRR store per pin. Only compiled
+  * 	   as reference for benchmark_lcd().
+  * @param uint8_t nibble bits to put on DB4-DB7
+  * @retval None
+  */
+void set_nibble_pins(uint8_t nibble) {
+	gpio_write(DB4_GPIO_Port, DB4_Pin, nibble & 1);
+	gpio_write(DB5_GPIO_Port, DB5_Pin, nibble & 2);
+	gpio_write(DB6_GPIO_Port, DB6_Pin, nibble & 4);
+	gpio_write(DB7_GPIO_Port, DB7_Pin, nibble & 8);
+}
+#endif
+
 /**
   * @brief Sets register select pin low in preparation for sending
   * 	   instructions to the display
   * @retval None
   */
 void setRSInstruction() {
-	HAL_GPIO_WritePin(LCD_RS_GPIO_Port, LCD_RS_Pin, GPIO_PIN_RESET);
+	gpio_reset(LCD_RS_GPIO_Port, LCD_RS_Pin);
 }
 
 /**
@@ -66,7 +308,7 @@ void setRSInstruction() {
   * @retval None
   */
 void setRSData() {
-	HAL_GPIO_WritePin(LCD_RS_GPIO_Port, LCD_RS_Pin, GPIO_PIN_SET);
+	gpio_set(LCD_RS_GPIO_Port, LCD_RS_Pin);
 }
 
 /**
@@ -77,64 +319,270 @@ void setRSData() {
   * @retval None
   */
 void send_enable_pulse() {
-	HAL_GPIO_WritePin(LCD_Enable_GPIO_Port, LCD_Enable_Pin, GPIO_PIN_SET);
+	gpio_set(LCD_Enable_GPIO_Port, LCD_Enable_Pin);
+	delayUs(1);
+	gpio_reset(LCD_Enable_GPIO_Port, LCD_Enable_Pin);
+	delayUs(1);
+}
+
+/**
+  * @brief Puts a nibble on the data pins DB4-DB7 with one table lookup and
+  * 	   BSRR store per port.
+  * @param uint8_t nibble bits to put on DB4-DB7, upper 4 bits are ignored
+  * @retval None
+  */
+void set_nibble(uint8_t nibble) {
+	nibble &= 0x0F;
+	gpio_write_bsrr(DB4_GPIO_Port, nibble_db4_db6[nibble]);
+	gpio_write_bsrr(DB7_GPIO_Port, nibble_db7[nibble]);
+}
+
+/**
+  * @brief Switches the data pins between input and output, DB0-DB3 too in 8 bit mode.
+  * @param uint32_t mode GPIO_MODE_INPUT or GPIO_MODE_OUTPUT_PP
+  * @retval None
+  */
+void set_data_pins_mode(uint32_t mode) {
+	gpio_mode(DB4_GPIO_Port, DB4_Pin | DB5_Pin | DB6_Pin, mode);
+	gpio_mode(DB7_GPIO_Port, DB7_Pin, mode);
+#ifdef LCD_8BIT
+	gpio_mode(DB0_GPIO_Port, DB0_DB3_Pins, mode);
+#endif
+}
+
+/**
+  * @brief Reads the busy flag. The data pins are switched to input and R/W to
+  * 	   read, then busy flag and address counter are clocked out, in 4 bit mode
+  * 	   as two nibbles. The data pins are 5 V tolerant. Only used if LCD_RW_Pin is defined.
+  * @retval uint8_t TRUE if the display is busy, FALSE otherwise
+  */
+uint8_t read_busy_flag() {
+#ifdef LCD_RW_Pin
+	uint8_t busy;
+
+	set_data_pins_mode(GPIO_MODE_INPUT);
+	gpio_reset(LCD_RS_GPIO_Port, LCD_RS_Pin);
+	gpio_set(LCD_RW_GPIO_Port, LCD_RW_Pin);
+
+	gpio_set(LCD_Enable_GPIO_Port, LCD_Enable_Pin);	// high nibble, DB7 is the busy flag
 	delayUs(1);
-	HAL_GPIO_WritePin(LCD_Enable_GPIO_Port, LCD_Enable_Pin, GPIO_PIN_RESET);
+	busy = (gpio_read(DB7_GPIO_Port, DB7_Pin) != 0);
+	gpio_reset(LCD_Enable_GPIO_Port, LCD_Enable_Pin);
 	delayUs(1);
+#ifndef LCD_8BIT
+	send_enable_pulse();								// low nibble of address counter is ignored
+#endif
+
+	gpio_reset(LCD_RW_GPIO_Port, LCD_RW_Pin);
+	set_data_pins_mode(GPIO_MODE_OUTPUT_PP);
+	return busy;
+#else
+	return FALSE;
+#endif
+}
+
+/**
+  * @brief Waits till the display has processed a byte. Polls the busy flag if
+  * 	   enabled, otherwise waits the worst case execution time. If the busy flag
+  * 	   doesn't clear within BUSY_TIMEOUT, the fixed delays are used from then on.
+  * @param uint8_t byte byte that was sent
+  * @param uint8_t instruction TRUE if the byte was an instruction, FALSE for data
+  * @retval None
+  */
+void wait_ready(uint8_t byte, uint8_t instruction) {
+	uint8_t clear = (instruction && (byte == CLEAR_DISPLAY || byte == HOME));
+
+	if (lcd_busy_flag) {
+		uint16_t deadline = delay_deadline(BUSY_TIMEOUT);
+		while (read_busy_flag()) {
+			if (delay_expired(deadline)) {				// worst case is waited already
+				lcd_busy_flag = FALSE;
+				lcd_busy_timeouts++;
+				break;
+			}
+		}
+		return;
+	}
+	if (clear) HAL_Delay(CLEAR_TIME);
+	else delayUs(EXECUTION_TIME);
 }
 
 /**
-  * @brief First sends a high nibble then a low nibble to the display each followed
-  * 	   by an enable pulse. This function is specific to 4 bit mode. As it splits
-  * 	   the parameter byte into to nibbles and sends them separatly. Not usable
-  * 	   for 8 bit mode.
+  * @brief In 4 bit mode first sends a high nibble then a low nibble to the display
+  * 	   each followed by an enable pulse. In 8 bit mode the low nibble is put on
+  * 	   DB0-DB3 at the same time and one enable pulse sends the whole byte.
   * @param uint8_t byte byte as data or instruction to send to the display. Can be
   * 					 a instruction from the defined instructions in this file or a char
   * 					 as data.
   * @retval None
   */
 void send_byte_to_lcd(uint8_t byte) {
-
+#ifdef LCD_8BIT
+	gpio_write_bsrr(DB0_GPIO_Port, nibble_db0_db3[byte & 0x0F]);
+	set_nibble(byte >> 4);
+	send_enable_pulse();
+#else
 	// Send high nibble
-	for (uint8_t i = 0; i < 4; i++ ) {
-		if (byte >> (i + 4) & 1) HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_SET);
-		else HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_RESET);
-	}
+	set_nibble(byte >> 4);
 	send_enable_pulse();
 
 	// send low nibble
-	for (uint8_t i = 0; i < 4; i++ ) {
-		if (byte >> i & 1) HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_SET);
-		else HAL_GPIO_WritePin(LCD_PORTS[i], LCD_PINS[i], GPIO_PIN_RESET);
+	set_nibble(byte);
+	send_enable_pulse();
+#endif
+}
+
+/**
+  * @brief Puts an entry into the queue and starts the timer interrupt, if it
+  * 	   has drained the queue already. With LCD_I2C it's added to the I2C batch.
+  * @param uint16_t entry byte with QUEUE_DATA and QUEUE_CLEAR flags
+  * @retval uint8_t TRUE if queued, FALSE if the queue is full
+  */
+uint8_t enqueue(uint16_t entry) {
+#ifdef LCD_I2C
+	return lcd_i2c_queue(entry, (entry & QUEUE_DATA) != 0, (entry & QUEUE_CLEAR) != 0);
+#else
+	uint8_t head = lcd_queue_head;
+
+	if ((uint8_t) (head - lcd_queue_tail) == QUEUE_SIZE) return FALSE;
+	lcd_queue[head & (QUEUE_SIZE - 1)] = entry;
+	lcd_queue_head = head + 1;
+	if (!lcd_sending) {									// interrupt clears it only with an empty queue
+		lcd_sending = TRUE;
+		lcd_nibble = 0;
+		arm_display_timer(NIBBLE_TIME);
+		__HAL_TIM_CLEAR_FLAG(lcd_htim, TIM_FLAG_UPDATE);
+		HAL_TIM_Base_Start_IT(lcd_htim);
 	}
+	return TRUE;
+#endif
+}
+
+/**
+  * @brief Sets the time till the next timer interrupt.
+  * @param uint16_t time time in us
+  * @retval None
+  */
+void arm_display_timer(uint16_t time) {
+	__HAL_TIM_SET_COUNTER(lcd_htim, 0);
+	__HAL_TIM_SET_AUTORELOAD(lcd_htim, time - 1);
+}
+
+/**
+  * @brief Has to be called by the period elapsed callback of the timer given to
+  * 	   display_start_async(). Sends one nibble of the oldest queued byte with its
+  * 	   enable pulse, in 8 bit mode the whole byte. After the low nibble the timer
+  * 	   waits the execution time of the byte, no busy waiting. Stops the timer when the queue is empty.
+  * 	   Called in interrupt context.
+  * @retval None
+  */
+void display_timer_tick() {
+	uint8_t tail = lcd_queue_tail;
+	uint16_t entry;
+
+	if (tail == lcd_queue_head) {
+		HAL_TIM_Base_Stop_IT(lcd_htim);
+		lcd_sending = FALSE;
+		return;
+	}
+	entry = lcd_queue[tail & (QUEUE_SIZE - 1)];
+#ifdef LCD_8BIT
+	if (entry & QUEUE_DATA) setRSData();
+	else setRSInstruction();
+	send_byte_to_lcd(entry);
+#else
+	if (lcd_nibble == 0) {
+		if (entry & QUEUE_DATA) setRSData();
+		else setRSInstruction();
+		set_nibble(entry >> 4);
+		send_enable_pulse();
+		lcd_nibble = 1;
+		arm_display_timer(NIBBLE_TIME);
+		return;
+	}
+	set_nibble(entry);
 	send_enable_pulse();
+	lcd_nibble = 0;
+#endif
+	lcd_queue_tail = tail + 1;
+	arm_display_timer(entry & QUEUE_CLEAR ? CLEAR_TIME * 1000 : EXECUTION_TIME);
+}
+
+/**
+  * @brief Switches from blocking transfers to the queue drained by the timer
+  * 	   interrupt. Has to be called after init_display(). The timer has to be
+  * 	   initialized with a 1 MHz counter clock and without auto reload preload,
+  * 	   its period elapsed callback has to call display_timer_tick().
+  * 	   The busy flag isn't polled by the interrupt, it waits the fixed times.
+  * 	   With LCD_I2C the timer isn't used, each display update is sent as one
+  * 	   I2C transaction by DMA.
+  * @param TIM_HandleTypeDef* htim timer handle
+  * @retval None
+  */
+void display_start_async(TIM_HandleTypeDef* htim) {
+	lcd_htim = htim;
+}
+
+/**
+  * @brief Tells if all queued bytes were sent to the display.
+  * @retval uint8_t TRUE if the queue is empty and the last byte was processed
+  */
+uint8_t is_display_idle() {
+#ifdef LCD_I2C
+	return lcd_i2c_idle();
+#else
+	return !lcd_sending;
+#endif
 }
 
 /**
   * @brief Separate function to specifically send instructions to the display.
   * 	   Encapsules register selection sending instruction and waiting for the display
-  * 	   to process the instruction
+  * 	   to process the instruction. After display_start_async() it's only queued.
   * @param uint8_t byte instruction to send. Use only instructions defined in this file.
-  * @retval None
+  * @retval uint8_t TRUE if sent or queued, FALSE if the queue is full
   */
-void send_instruction(uint8_t byte) {
-	setRSInstruction();
-	send_byte_to_lcd(byte);
-	if (byte == CLEAR_DISPLAY || byte == HOME) HAL_Delay(2);
-	else delayUs(50);
+uint8_t send_instruction(uint8_t byte) {
+	if (lcd_htim) {
+		if (!enqueue(byte | (byte == CLEAR_DISPLAY || byte == HOME ? QUEUE_CLEAR : 0))) return FALSE;
+	} else {
+#ifdef LCD_I2C
+		lcd_i2c_write(byte, FALSE);
+#else
+		setRSInstruction();
+		send_byte_to_lcd(byte);
+#endif
+		wait_ready(byte, TRUE);
+	}
+	if (byte & SET_DDRAM_ADDRESS) lcd_address = byte & 0x7F;
+	else if (byte & SET_CGRAM_ADDRESS) lcd_address = CGRAM | (byte & 0x3F);
+	else if (byte == CLEAR_DISPLAY || byte == HOME) lcd_address = 0;
+	lcd_flush_bytes++;
+	return TRUE;
 }
 
 /**
   * @brief Separate function to specifically send data to the display.
   * 	   Encapsules register selection sending data and waiting for the display
-  * 	   to process the instruction
+  * 	   to process the instruction. After display_start_async() it's only queued.
   * @param uint8_t byte instruction to send. Use only instruction defined in this file.
-  * @retval None
+  * @retval uint8_t TRUE if sent or queued, FALSE if the queue is full
   */
-void send_data(uint8_t byte) {
-	setRSData();
-	send_byte_to_lcd(byte);
-	delayUs(50);
+uint8_t send_data(uint8_t byte) {
+	if (lcd_htim) {
+		if (!enqueue(byte | QUEUE_DATA)) return FALSE;
+	} else {
+#ifdef LCD_I2C
+		lcd_i2c_write(byte, TRUE);
+#else
+		setRSData();
+		send_byte_to_lcd(byte);
+#endif
+		wait_ready(byte, FALSE);
+	}
+	lcd_address = NEXT_ADDRESS(lcd_address);			// display increments the address counter
+	lcd_flush_bytes++;
+	return TRUE;
 }
 
 /**
@@ -143,42 +591,431 @@ void send_data(uint8_t byte) {
   * 	   		- Wait for Power Delay 50ms
   * 	   		- Set 8 bit mode
   * 	   		- Set 8 bit mode
-  * 	   		- Set 4 bit mode
-  * 	   		- Configure display to 2 lines and 5*8 characters
+  * 	   		- Set 4 bit mode, 8 bit mode again if LCD_8BIT is defined
+  * 	   		- Configure display to 2 lines and 5*8 characters, 4 row displays too
   * 	   		- Turn display off
   * 	   		- Clear display
   * 	   		- Turn display on
-  * 	   	Afterwards the display is ready to use.
+  * 	   	Afterwards the display is ready to use. If LCD_RW_Pin is defined,
+  * 	   	the busy flag is polled from 4 bit mode on. The big digit glyphs
+  * 	   	are loaded into CGRAM.
   * @retval None
   */
 void init_display() {
+#if defined(LCD_RW_Pin) || defined(LCD_8BIT)
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+#endif
+
+#ifdef LCD_RW_Pin
+	/* R/W isn't configured by CubeMX, low is write */
+	gpio_reset(LCD_RW_GPIO_Port, LCD_RW_Pin);
+	GPIO_InitStruct.Pin = LCD_RW_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_Init(LCD_RW_GPIO_Port, &GPIO_InitStruct);
+#endif
+#ifdef LCD_8BIT
+	/* DB0-DB3 aren't configured by CubeMX */
+	GPIO_InitStruct.Pin = DB0_DB3_Pins;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_Init(DB0_GPIO_Port, &GPIO_InitStruct);
+#endif
+	lcd_busy_flag = FALSE;				// busy flag can't be read before the interface is set
 	HAL_Delay(50);						// wait power on delay
 	send_instruction(LCD_8BIT_MODE); 	// 8 bit mode
 	send_instruction(LCD_8BIT_MODE);	// 8 bit mode
+#ifdef LCD_8BIT
+	send_instruction(LCD_8BIT_MODE);	// 8 bit mode
+#else
 	send_instruction(LCD_4BIT_MODE);	// 4 bit mode
+#endif
+#ifdef LCD_RW_Pin
+	lcd_busy_flag = TRUE;
+#endif
+#ifdef LCD_8BIT
+	send_instruction(LCD_8BIT_TWOLINES_5_8); // 2 lines, 5*8 chars
+#else
 	send_instruction(LCD_TWOLINES_5_8); // 2 lines, 5*8 chars
+#endif
 	send_instruction(DISPLAY_OFF); 		// turn off
 	send_instruction(CLEAR_DISPLAY); 	// clear display
 	send_instruction(DISPLAY_ON); 	    // turn on
+	lcd_cursor = CURSOR_OFF;
+	lcd_cursor_position = 0;
+	for (uint8_t slot = 0; slot < GLYPHS; slot++) {	// CGRAM content is random after power on
+		for (uint8_t row = 0; row < GLYPH_ROWS; row++) {
+			cgram[slot][row] = 0xFF;					// glyph rows are 5 bit, every row is written
+		}
+	}
+	glyph_set = Glyphs_none;
+	load_glyph_set(Glyphs_big_digits);
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {	// cleared display shows spaces
+		for (uint8_t col = 0; col < LCD_COLS; col++) {
+			screen[row][col] = ' ';
+			frame[row][col] = ' ';
+		}
+	}
+}
+
+/**
+  * @brief Writes the time as HH:MM:SS into the frame.
+  * @param uint8_t row row of the display, 0 or 1
+  * @param uint8_t col column of the first digit
+  * @param RTC_TimeTypeDef gTime time to show
+  * @retval None
+  */
+void render_time(uint8_t row, uint8_t col, RTC_TimeTypeDef gTime) {
+	format_time(&frame[row][col], gTime.Hours, gTime.Minutes, gTime.Seconds);
+}
+
+/**
+  * @brief Writes the temperature into the frame, marked with '?' if stale and
+  * 	   replaced by dashes if missing.
+  * @param uint8_t row row of the display, 0 or 1
+  * @param int16_t temperature temperature in degrees C * 10
+  * @param enum Temp_state temp_state state of the temperature
+  * @retval None
+  */
+void render_temperature(uint8_t row, int16_t temperature, enum Temp_state temp_state) {
+	char* end;
+
+	if (temp_state == Temp_missing) {
+		format_text(&frame[row][TEMP_COL], temp_missing);
+		return;
+	}
+	end = format_temperature(&frame[row][TEMP_COL], temperature);
+	if (temp_state == Temp_stale) *end = '?';
+}
+
+/**
+  * @brief Writes the humidity in percent into the frame.
+  * @param uint8_t row row of the display, 0 or 1
+  * @param uint16_t humidity humidity in percent
+  * @retval None
+  */
+void render_humidity(uint8_t row, uint16_t humidity) {
+	*format_uint(&frame[row][HUMIDITY_COL], humidity) = '%';
+}
+
+/**
+  * @brief Writes the time with big digits into both rows of the frame, HH:MM
+  * 	   with 3 * 2 cells per digit and the seconds small in the second row.
+  * 	   Needs the big digit glyphs.
+  * @param RTC_TimeTypeDef gTime time to show
+  * @retval None
+  */
+void render_big_clock(RTC_TimeTypeDef gTime) {
+	uint8_t digits[4] = {gTime.Hours / 10, gTime.Hours % 10, gTime.Minutes / 10, gTime.Minutes % 10};
+
+	for (uint8_t i = 0; i < 4; i++) {
+		uint8_t col = (i < 2 ? BIG_HOURS_COL : BIG_MINUTES_COL) + (i & 1) * BIG_DIGIT_WIDTH;
+		for (uint8_t cell = 0; cell < BIG_DIGIT_WIDTH; cell++) {
+			frame[0][col + cell] = big_digits[digits[i]][cell];
+			frame[1][col + cell] = big_digits[digits[i]][BIG_DIGIT_WIDTH + cell];
+		}
+	}
+	frame[0][BIG_COLON_COL] = MIDDLE_DOT;
+	frame[1][BIG_COLON_COL] = MIDDLE_DOT;
+	format_2digits(&frame[1][BIG_SECONDS_COL], gTime.Seconds);
+}
+
+/**
+  * @brief Writes the temperature history as bars into a row of the frame, one
+  * 	   cell per sample, scaled between lowest and highest sample. Needs the bar glyphs.
+  * @param uint8_t row row of the display, 0 or 1
+  * @retval None
+  */
+void render_sparkline(uint8_t row) {
+	int16_t low = history[0];
+	int16_t high = history[0];
+
+	for (uint8_t i = 1; i < history_count; i++) {
+		if (history[i] < low) low = history[i];
+		if (history[i] > high) high = history[i];
+	}
+	for (uint8_t i = 0; i < history_count; i++) {
+		uint8_t level = GLYPHS / 2 - 1;					// flat history is shown in the middle
+		if (high > low) level = (int32_t) (history[i] - low) * (GLYPHS - 1) / (high - low);
+		frame[row][SPARKLINE_COL + i] = GLYPH(level);
+	}
+}
+
+/**
+  * @brief Renders the rows of a view into the frame. Fields are formatted in
+  * 	   place, all other cells are spaces.
+  * @param parameters see write_to_display()
+  * @retval None
+  */
+void render_view(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, uint8_t toggle_mode) {
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		for (uint8_t col = 0; col < LCD_COLS; col++) {
+			frame[row][col] = ' ';
+		}
+	}
+
+	switch (mode) {
+		case Time_only:
+		case Time_conf:
+			render_time(0, TIME_COL, gTime);
+			break;
+
+		case Time_and_Temp:
+			render_temperature(0, temperature, temp_state);
+			render_time(1, TIME_COL_SECOND, gTime);
+			break;
+
+		case Temp_and_humidity:
+			render_temperature(0, temperature, temp_state);
+			render_humidity(1, humidity);
+			break;
+
+		case Temp_humi_and_clock:
+			if (toggle_mode == TRUE) {
+				render_temperature(0, temperature, temp_state);
+				render_humidity(1, humidity);
+			} else {
+				render_time(0, TIME_COL, gTime);
+			}
+			break;
+
+		case Big_clock:
+			render_big_clock(gTime);
+			break;
+
+		case Temp_history:
+			render_temperature(0, temperature, temp_state);
+			render_sparkline(1);
+			break;
+	}
+}
+
+/**
+  * @brief Sends the cells of the frame that differ from the display. The address
+  * 	   counter is only set where the next changed cell isn't the one it points to
+  * 	   anyway. The cursor instructions are only sent if the cursor changed or
+  * 	   the address counter was moved away from a blinking cursor.
+  * 	   Bytes sent and duration are stored for get_flush_stats(), with the queue
+  * 	   the duration is the time to fill it. If the queue hasn't room for all
+  * 	   bytes, nothing is queued, the cells still differ and are sent by the next flush.
+  * @param uint8_t cursor cursor mode instruction, CURSOR_OFF or CURSOR_ON_BLINKING
+  * @param uint8_t position SET_CURSOR_* instruction for the blinking cursor, 0 if none
+  * @retval uint8_t TRUE if the whole frame was sent or queued, FALSE if the queue was full
+  */
+uint8_t flush_display(uint8_t cursor, uint8_t position) {
+	uint8_t moved = FALSE;
+
+	if (flush_length() + 2 > queue_room()) {			// cursor instructions need 2 entries at most
+		lcd_queue_full++;
+		return FALSE;
+	}
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		for (uint8_t col = 0; col < LCD_COLS; col++) {
+			uint8_t address = ROW_ADDRESS(row) + col;
+			if (frame[row][col] == screen[row][col]) continue;
+			if (lcd_address != address) send_instruction(SET_DDRAM_ADDRESS | address);
+			send_data(frame[row][col]);
+			screen[row][col] = frame[row][col];
+			moved = TRUE;
+		}
+	}
+	if (cursor != lcd_cursor) {
+		send_instruction(cursor);
+		lcd_cursor = cursor;
+	}
+	if (position && (moved || position != lcd_cursor_position)) send_instruction(position);
+	lcd_cursor_position = position;
+	return TRUE;
+}
+
+/**
+  * @brief Returns the free entries of the queue.
+  * @retval uint8_t free entries, 0xFF while sending blocking
+  */
+uint8_t queue_room() {
+	if (!lcd_htim) return 0xFF;
+#ifdef LCD_I2C
+	return lcd_i2c_room();
+#else
+	return QUEUE_SIZE - (uint8_t) (lcd_queue_head - lcd_queue_tail);
+#endif
+}
+
+#ifdef LCD_I2C
+/**
+  * @brief Forgets what the display and CGRAM show after an I2C batch was
+  * 	   dropped, so the next update sends every cell and glyph row again.
+  * @retval None
+  */
+void forget_display() {
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		for (uint8_t col = 0; col < LCD_COLS; col++) screen[row][col] = '\0';	// never rendered
+	}
+	for (uint8_t slot = 0; slot < GLYPHS; slot++) {
+		for (uint8_t row = 0; row < GLYPH_ROWS; row++) cgram[slot][row] = 0xFF;	// glyph rows are 5 bit
+	}
+	glyph_set = Glyphs_none;
+	lcd_address = NO_ADDRESS;
+	lcd_cursor = 0;
+}
+#endif
+
+/**
+  * @brief Writes the rows of a glyph that differ from CGRAM. The CGRAM address
+  * 	   is only set where the next changed row isn't the one it points to anyway.
+  * @param uint8_t slot glyph number, 0 to 7
+  * @param const uint8_t* rows GLYPH_ROWS rows of the glyph
+  * @retval uint8_t TRUE if written or queued, FALSE if the queue hasn't room
+  */
+uint8_t upload_glyph(uint8_t slot, const uint8_t* rows) {
+	if (2 * GLYPH_ROWS > queue_room()) return FALSE;	// worst case, address before every row
+	for (uint8_t row = 0; row < GLYPH_ROWS; row++) {
+		uint8_t address = slot * GLYPH_ROWS + row;
+		if (cgram[slot][row] == rows[row]) continue;
+		if (lcd_address != (CGRAM | address)) send_instruction(SET_CGRAM_ADDRESS | address);
+		send_data(rows[row]);
+		cgram[slot][row] = rows[row];
+	}
+	return TRUE;
+}
+
+/**
+  * @brief Loads a glyph set into CGRAM, if it isn't loaded already. Only rows
+  * 	   that differ from the current glyphs are written. If the queue runs full,
+  * 	   the next call continues with the rows left.
+  * @param enum Glyph_set set glyph set to load
+  * @retval uint8_t TRUE if the glyph set is loaded or queued, FALSE if the queue was full
+  */
+uint8_t load_glyph_set(enum Glyph_set set) {
+	const uint8_t (*glyphs)[GLYPH_ROWS] = (set == Glyphs_bars ? bar_glyphs : big_digit_glyphs);
+
+	if (set == glyph_set) return TRUE;
+	glyph_set = Glyphs_none;
+	for (uint8_t slot = 0; slot < GLYPHS; slot++) {
+		if (!upload_glyph(slot, glyphs[slot])) {
+			lcd_queue_full++;
+			return FALSE;
+		}
+	}
+	glyph_set = set;
+	return TRUE;
+}
+
+/**
+  * @brief Adds a temperature sample to the history shown by the sparkline,
+  * 	   the oldest sample is dropped if the history is full.
+  * @param int16_t temperature temperature in degrees C * 10
+  * @retval None
+  */
+void add_temperature_history(int16_t temperature) {
+	if (history_count == HISTORY_LENGTH) {
+		for (uint8_t i = 1; i < HISTORY_LENGTH; i++) history[i - 1] = history[i];
+		history_count--;
+	}
+	history[history_count++] = temperature;
+}
+
+/**
+  * @brief Counts the bytes flush_display() sends for the changed cells,
+  * 	   address jumps included.
+  * @retval uint8_t number of bytes
+  */
+uint8_t flush_length() {
+	uint8_t address = lcd_address;
+	uint8_t length = 0;
+
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		for (uint8_t col = 0; col < LCD_COLS; col++) {
+			if (frame[row][col] == screen[row][col]) continue;
+			if (address != ROW_ADDRESS(row) + col) length++;
+			address = NEXT_ADDRESS(ROW_ADDRESS(row) + col);
+			length++;
+		}
+	}
+	return length;
+}
+
+/**
+  * @brief Returns the statistics of the last display update.
+  * @param uint8_t* bytes is set to the number of instruction and data bytes sent
+  * @param uint16_t* us is set to the time the caller was blocked by the update in us
+  * @param uint16_t* queue_full is set to the number of updates that didn't fit into the queue
+  * @retval None
+  */
+void get_flush_stats(uint8_t* bytes, uint16_t* us, uint16_t* queue_full) {
+	*bytes = lcd_flush_bytes;
+	*us = lcd_flush_us;
+	*queue_full = lcd_queue_full;
 }
 
 /**
   * @brief Actually writes data to the screen. Fills templates specified by parameter mode
   * 	   using result from get_temperature() called in main, the fields hours, mins, secs
   * 	   from the RTC_TimeTypeDef and the humidity read by adc. Also sets cursor if necessary. And
-  * 	   selects templates in toggle mode, depending on toggle_mode.
+  * 	   selects templates in toggle mode, depending on toggle_mode. The rows are
+  * 	   rendered into the frame, only changed cells are sent to the display. After
+  * 	   display_start_async() they are only queued and the function returns immediately.
   * @param float temperature representation of the read temperature, value is received by get_temperature()
   * 						 in main
+  * @param enum Temp_state temp_state Temp_stale if temperature is too old, it's marked with '?' then,
+  * 							   Temp_missing if sensor doesn't answer, no value is shown then
   * @param RTC_TimeTypeDef gTime typedef containing current time info, handled by RTC
   * @param enum View_mode mode currently selected view mode to choose from templates
   * @param enum Time_frac_selected selected if in Time_conf mode, where to set the cursor
   * @param uint8_t toggle_mode if in Toggle_mode which is the current state.
+  * @retval uint8_t TRUE if the update was sent or queued completely, FALSE if the
+  * 		   queue was full, has to be called again then
+  */
+uint8_t write_to_display(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, enum Time_frac_selected selected, uint8_t toggle_mode) {
+	uint16_t start = delay_now();
+	uint8_t done;
+
+	lcd_flush_bytes = 0;
+#ifdef LCD_I2C
+	if (lcd_i2c_failed()) forget_display();
+#endif
+	render_view(humidity, temperature, temp_state, gTime, mode, toggle_mode);
+
+	// Glyphs of the view have to be in CGRAM before its cells are written
+	if (mode == Big_clock) done = load_glyph_set(Glyphs_big_digits);
+	else if (mode == Temp_history) done = load_glyph_set(Glyphs_bars);
+	else done = TRUE;
+
+	// If there is a timefrac selected, enable cursor and set to correct position
+	if (!done);
+	else if (selected == hours_sel) done = flush_display(CURSOR_ON_BLINKING, SET_CURSOR_HOURS);
+	else if (selected == mins_sel) done = flush_display(CURSOR_ON_BLINKING, SET_CURSOR_MINS);
+	else if (selected == secs_sel) done = flush_display(CURSOR_ON_BLINKING, SET_CURSOR_SECS);
+	else done = flush_display(CURSOR_OFF, 0);
+#ifdef LCD_I2C
+	if (lcd_htim) lcd_i2c_send();						// whole update is one I2C transaction
+#endif
+	lcd_flush_us = delay_elapsed_us(start);
+	return done;
+}
+
+#ifdef BENCHMARK_ENABLED
+/**
+  * @brief Copies a row of text into the frame, cut or padded with spaces to LCD_COLS.
+  * @param uint8_t row row of the display, 0 or 1
+  * @param const char* text zero terminated text of the row
   * @retval None
   */
-void write_to_display(uint16_t humidity, int16_t temperature, RTC_TimeTypeDef gTime, enum View_mode mode, enum Time_frac_selected selected, uint8_t toggle_mode) {
-	// reset cursor to home for write
-	send_instruction(HOME);
+void render_row(uint8_t row, const char* text) {
+	for (uint8_t col = 0; col < LCD_COLS; col++) {
+		frame[row][col] = (*text ? *text++ : ' ');
+	}
+}
 
+/**
+  * @brief Renders a view with sprintf() like the driver did before format_lib.
+  * 	   Only compiled as reference for benchmark_lcd().
+  * @param parameters see write_to_display()
+  * @retval None
+  */
+void render_view_sprintf(uint16_t humidity, int16_t temperature, enum Temp_state temp_state, RTC_TimeTypeDef gTime, enum View_mode mode, uint8_t toggle_mode) {
 	// Setting up strings to display
 	char first_row[64];
 	char sec_row[64];
@@ -188,6 +1025,9 @@ void write_to_display(uint16_t humidity, int16_t temperature, RTC_TimeTypeDef gT
 	int16_t temp_int = 0;
 	int16_t temp_frac = 0;
 	char *temp_sign;
+	const char* temp_format = temp_row;
+	if (temp_state == Temp_stale) temp_format = temp_stale_row;
+	else if (temp_state == Temp_missing) temp_format = temp_missing_row;
 	if (temperature < 0) {
 		temp_sign = "-";
 		temp_int = -temperature / 10;
@@ -207,12 +1047,12 @@ void write_to_display(uint16_t humidity, int16_t temperature, RTC_TimeTypeDef gT
 			break;
 
 		case Time_and_Temp:
-			sprintf(first_row, temp_row, temp_sign, temp_int, temp_frac);
+			sprintf(first_row, temp_format, temp_sign, temp_int, temp_frac);
 			sprintf(sec_row, time_second_row, gTime.Hours, gTime.Minutes, gTime.Seconds);
 			break;
 
 		case Temp_and_humidity:
-			sprintf(first_row, temp_row, temp_sign, temp_int, temp_frac);
+			sprintf(first_row, temp_format, temp_sign, temp_int, temp_frac);
 			sprintf(sec_row, humidity_row , humidity);
 			break;
 
@@ -223,38 +1063,88 @@ void write_to_display(uint16_t humidity, int16_t temperature, RTC_TimeTypeDef gT
 
 		case Temp_humi_and_clock:
 			if (toggle_mode == TRUE) {
-				sprintf(first_row, temp_row, temp_sign, temp_int, temp_frac);
+				sprintf(first_row, temp_format, temp_sign, temp_int, temp_frac);
 				sprintf(sec_row, humidity_row , humidity);
 			} else {
 				sprintf(first_row, time_only_first_row, gTime.Hours, gTime.Minutes, gTime.Seconds);
 				sprintf(sec_row, empty_row);
 			}
 			break;
-	}
 
-	// Write first line to display
-	for (int i = 0; first_row[i] != 0; i++) {
-		send_data(first_row[i]);
+		default:										// glyph views have no sprintf() reference
+			sprintf(first_row, empty_row);
+			sprintf(sec_row, empty_row);
+			break;
 	}
 
-	// set cursor to second line
-	send_instruction(SET_CURSOR_SEC_LINE);
+	// Render both rows into the frame
+	render_row(0, first_row);
+	render_row(1, sec_row);
+}
+#endif
 
-	// Write second line to display
-	for (int i = 0; sec_row[i] != 0; i++) {
-		send_data(sec_row[i]);
+/**
+  * @brief Measures the cycles to put both nibbles of a character on DB4-DB7
+  * 	   with the HAL loop, with one BSRR store per pin and with the lookup tables.
+  * 	   Each variant sends LCD_BENCH_CALLS characters, the average per character
+  * 	   is recorded in bench_results. Enable pulses and delays are left out, they
+  * 	   are the same for all variants. The display ignores the data pins then.
+  * 	   Rendering a refresh with sprintf() and with format_lib is recorded in
+  * 	   cycles and stack bytes.
+  * 	   Then the throughput of send_data() in characters per second is stored in
+  * 	   lcd_chars_per_second, with fixed delays and, if available, with busy flag.
+  * 	   Has to be called after init_display(), before the first update.
+  * @retval None
+  */
+void benchmark_lcd() {
+#ifdef BENCHMARK_ENABLED
+	uint32_t start = bench_cycles();
+	for (uint8_t i = 0; i < LCD_BENCH_CALLS; i++) {
+		set_nibble_hal(i >> 4);
+		set_nibble_hal(i);
 	}
+	bench_record(BENCH_LCD_CHAR_HAL, (bench_cycles() - start) / LCD_BENCH_CALLS);
 
+	start = bench_cycles();
+	for (uint8_t i = 0; i < LCD_BENCH_CALLS; i++) {
+		set_nibble_pins(i >> 4);
+		set_nibble_pins(i);
+	}
+	bench_record(BENCH_LCD_CHAR_PINS, (bench_cycles() - start) / LCD_BENCH_CALLS);
 
-	// If there is a timefrac selected, enable cursor and set to correct position
-	if (selected != None_sel) {
-		send_instruction(CURSOR_ON_BLINKING);
-		if (selected == hours_sel) send_instruction(SET_CURSOR_HOURS);
-		else if (selected == mins_sel) send_instruction(SET_CURSOR_MINS);
-		else if (selected == secs_sel) send_instruction(SET_CURSOR_SECS);
-	} else send_instruction(CURSOR_OFF);
-
-}
-
+	start = bench_cycles();
+	for (uint8_t i = 0; i < LCD_BENCH_CALLS; i++) {
+		set_nibble(i >> 4);
+		set_nibble(i);
+	}
+	bench_record(BENCH_LCD_CHAR_TABLE, (bench_cycles() - start) / LCD_BENCH_CALLS);
 
+	/* Rendering of a refresh, cycles and stack */
+	for (uint8_t variant = 0; variant < 2; variant++) {
+		RTC_TimeTypeDef time = {0};
+		time.Hours = 12;
+		time.Minutes = 34;
+		time.Seconds = 56;
+		bench_stack_paint();
+		start = bench_cycles();
+		if (variant == 0) render_view_sprintf(45, -123, Temp_valid, time, Time_and_Temp, FALSE);
+		else render_view(45, -123, Temp_valid, time, Time_and_Temp, FALSE);
+		bench_record(variant == 0 ? BENCH_RENDER_SPRINTF : BENCH_RENDER_FORMAT, bench_cycles() - start);
+		bench_record(variant == 0 ? BENCH_STACK_SPRINTF : BENCH_STACK_FORMAT, bench_stack_used());
+	}
 
+	/* Throughput, spaces are written over the spaces of the cleared first row */
+	for (uint8_t mode = 0; mode < 2; mode++) {
+		uint8_t busy_flag = lcd_busy_flag;
+		if (mode == 1 && !busy_flag) break;				// R/W not wired or busy flag timed out
+		lcd_busy_flag = (mode == 1);
+		send_instruction(SET_DDRAM_ADDRESS);
+		start = bench_cycles();
+		for (uint8_t i = 0; i < LCD_BENCH_CHARS; i++) {
+			send_data(' ');
+		}
+		lcd_chars_per_second[mode] = (uint64_t) SystemCoreClock * LCD_BENCH_CHARS / (bench_cycles() - start);
+		lcd_busy_flag = busy_flag;
+	}
+#endif
+}
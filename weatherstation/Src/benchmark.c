@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file           : benchmark.c
+  * @brief          : Implements Functions to measure runtime in CPU cycles
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "benchmark.h"
+
+/* Pattern painted into the free stack by bench_stack_paint() ------------------*/
+#define STACK_PATTERN		0xA5A5A5A5
+
+/* Bytes below the stack pointer left alone, used by bench_stack_paint() itself */
+#define STACK_MARGIN		32
+
+/* Top and reserved size of the stack, from the linker script -------------------*/
+extern uint32_t _estack;
+extern uint32_t _Min_Stack_Size;
+
+/* Results of all measured sections -------------------------------------------*/
+struct Bench_result bench_results[BENCH_COUNT];
+
+uint32_t* stack_painted = NULL;				// stack pointer when the stack was painted
+
+/**
+  * @brief Returns a timestamp in CPU cycles. The Cortex-M0 has no cycle counter,
+  * 	   so the timestamp is combined from the HAL millisecond tick and the current
+  * 	   value of the SysTick down counter. A SysTick underflow which is pending but
+  * 	   not yet counted by HAL_IncTick() (e.g. when called from an interrupt) is
+  * 	   taken into account. Differences of two timestamps are valid as long as
+  * 	   they are shorter than 2^32 cycles (~89 s at 48 MHz).
+  * @retval uint32_t current timestamp in CPU cycles
+  */
+uint32_t bench_cycles() {
+	uint32_t ms;
+	uint32_t val;
+	uint32_t pending;
+	uint32_t reload = SysTick->LOAD;
+
+	do {
+		ms = HAL_GetTick();
+		val = SysTick->VAL;
+		pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+	} while (ms != HAL_GetTick());
+
+	if (pending && val > reload / 2) ms++;		// underflow happened, tick not incremented yet
+
+	return ms * (reload + 1) + (reload - val);
+}
+
+/**
+  * @brief Stores a measurement in the statistics of the given section.
+  * @param enum Bench_id id section the measurement belongs to
+  * @param uint32_t cycles measured cycles, usually difference of two bench_cycles()
+  * @retval None
+  */
+void bench_record(enum Bench_id id, uint32_t cycles) {
+	struct Bench_result* result = &bench_results[id];
+
+	result->last = cycles;
+	if (result->count == 0 || cycles < result->min) result->min = cycles;
+	if (cycles > result->max) result->max = cycles;
+	result->count++;
+}
+
+/**
+  * @brief Fills the unused part of the reserved stack with STACK_PATTERN, so
+  * 	   bench_stack_used() can find the deepest stack use of the following code.
+  * 	   Has to be called from the same function as bench_stack_used().
+  * @retval None
+  */
+void bench_stack_paint() {
+	uint32_t* bottom = (uint32_t*) ((uint32_t) &_estack - (uint32_t) &_Min_Stack_Size);
+	uint32_t* top = (uint32_t*) (__get_MSP() - STACK_MARGIN);
+
+	stack_painted = (uint32_t*) __get_MSP();
+	while (bottom < top) *bottom++ = STACK_PATTERN;
+}
+
+/**
+  * @brief Returns the stack used since bench_stack_paint(), below the stack
+  * 	   pointer at the time of painting. Interrupts in between are included.
+  * @retval uint32_t used stack in bytes
+  */
+uint32_t bench_stack_used() {
+	uint32_t* bottom = (uint32_t*) ((uint32_t) &_estack - (uint32_t) &_Min_Stack_Size);
+
+	while (bottom < stack_painted && *bottom == STACK_PATTERN) bottom++;
+	return (uint32_t) stack_painted - (uint32_t) bottom;
+}
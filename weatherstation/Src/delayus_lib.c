@@ -12,35 +12,147 @@
 
 #include "delayus_lib.h"
 
+/*
+ * TIM14 counts freely with DELAY_TICK_FREQ, waits compare against the counter.
+ * An interrupt during a wait only stretches it if it lasts past its end, and
+ * the delay doesn't depend on SYSCLK, flash latency or compiler optimization.
+ */
+#define DELAY_TIMER				TIM14
+#define DELAY_TICK_FREQ			8000000		// 125 ns resolution, counter wraps after 8 ms
+
+/* Longest wait compared against the 16 bit counter at once, in ticks ---------*/
+#define DELAY_CHUNK				0x8000
+
+#ifdef BENCHMARK_ENABLED
+/* Delays measured by benchmark_delay() in us ----------------------------------*/
+#define DELAY_BENCH_VALUES		{1, 2, 5, 10, 15, 50, 60, 70, 100, 410, 500, 1000}
+#define DELAY_BENCH_RUNS		8
+
+/* Requested vs actual delay, filled by benchmark_delay() ---------------------*/
+struct Delay_result delay_results[DELAY_BENCH_COUNT];
+#endif
+
+uint8_t delay_ticks_per_us = 0;				// counter ticks per us, set by delay_init()
+
 /**
-  * @brief Function to create a delay in microseconds
-  * @param us to wait
+  * @brief Starts the delay timer. The prescaler is calculated from SystemCoreClock
+  * 	   and the APB prescaler, so it has to be called again after the system
+  * 	   clock was changed. Has to be called before the first delay.
   * @retval None
-  * @pragmas used to turn off compiler optimization to ensure delay time is actually close to 1 us
   */
+void delay_init() {
+	uint32_t clock = HAL_RCC_GetPCLK1Freq();
+	uint32_t prescaler;
+
+	if ((RCC->CFGR & RCC_CFGR_PPRE) != RCC_CFGR_PPRE_DIV1) clock *= 2;	// timer runs at 2 * PCLK then
+	prescaler = clock / DELAY_TICK_FREQ;
+	if (prescaler == 0) prescaler = 1;				// clock slower than DELAY_TICK_FREQ
+	delay_ticks_per_us = clock / prescaler / 1000000;
+
+	__HAL_RCC_TIM14_CLK_ENABLE();
+	DELAY_TIMER->CR1 = 0;
+	DELAY_TIMER->PSC = prescaler - 1;
+	DELAY_TIMER->ARR = 0xFFFF;
+	DELAY_TIMER->EGR = TIM_EGR_UG;					// load prescaler
+	DELAY_TIMER->CR1 = TIM_CR1_CEN;
+}
 
-#pragma GCC push_options
-#pragma GCC optimize ("O0")
-inline void delayUs(uint16_t us) {
-	volatile uint16_t counter = 3 * us;	// 3 iterations give 0,06us difference per 1 us
-	while(counter--);
+/**
+  * @brief Returns the current value of the delay timer.
+  * @retval uint16_t counter value in ticks, delay_ticks_per_us ticks per us
+  */
+uint16_t delay_now() {
+	return DELAY_TIMER->CNT;
 }
-#pragma GCC pop_options
 
+/**
+  * @brief Returns the time passed since a value of delay_now(), for
+  * 	   measurements shorter than 8 ms.
+  * @param uint16_t start counter value from delay_now()
+  * @retval uint16_t passed time in us
+  */
+uint16_t delay_elapsed_us(uint16_t start) {
+	return (uint16_t) (DELAY_TIMER->CNT - start) / delay_ticks_per_us;
+}
 
-/*
-void delayUs(uint16_t us){
-	do {
-	asm volatile (
+/**
+  * @brief Waits at least the given time. Long delays are waited in chunks, so
+  * 	   the counter can't wrap around unnoticed.
+  * @param uint16_t us time to wait in us
+  * @retval None
+  */
+void delayUs(uint16_t us) {
+	uint16_t start = DELAY_TIMER->CNT;
+	uint32_t ticks = (uint32_t) us * delay_ticks_per_us;
 
-			"MOV R0,%[loops]\n\t"\
-			"1: \n\t"\
-			"SUB R0, #1\n\t"\
-			"CMP R0, #0\n\t"\
-			"BNE 1b \n\t" : : [loops] "r" (6*us) : "memory"\
+	while (ticks > DELAY_CHUNK) {
+		while ((uint16_t) (DELAY_TIMER->CNT - start) < DELAY_CHUNK);
+		start += DELAY_CHUNK;
+		ticks -= DELAY_CHUNK;
+	}
+	while ((uint16_t) (DELAY_TIMER->CNT - start) < ticks);
+}
+
+/**
+  * @brief Calculates a deadline, e.g. to do other work till a bus state has to end.
+  * @param uint16_t us time from now in us, at most 4000
+  * @retval uint16_t deadline for delay_expired() and delay_until()
+  */
+uint16_t delay_deadline(uint16_t us) {
+	return DELAY_TIMER->CNT + us * delay_ticks_per_us;
+}
+
+/**
+  * @brief Tells if a deadline has passed. Has to be checked within 4 ms after
+  * 	   the deadline, the counter wraps around after that.
+  * @param uint16_t deadline deadline from delay_deadline()
+  * @retval uint8_t TRUE if the deadline has passed, FALSE otherwise
+  */
+uint8_t delay_expired(uint16_t deadline) {
+	return (int16_t) (DELAY_TIMER->CNT - deadline) >= 0;
+}
 
-		      );
-	} while(0);
+/**
+  * @brief Waits till a deadline has passed.
+  * @param uint16_t deadline deadline from delay_deadline()
+  * @retval None
+  */
+void delay_until(uint16_t deadline) {
+	while ((int16_t) (DELAY_TIMER->CNT - deadline) < 0);
 }
 
-*/
+/**
+  * @brief Measures delayUs() with the values of DELAY_BENCH_VALUES, DELAY_BENCH_RUNS
+  * 	   times each. Results are stored in delay_results, to be compared against
+  * 	   the margins of the 1wire and LCD timing. The overhead of the measurement
+  * 	   itself is subtracted. Blocks ~30 ms.
+  * @retval None
+  */
+void benchmark_delay() {
+#ifdef BENCHMARK_ENABLED
+	const uint16_t values[DELAY_BENCH_COUNT] = DELAY_BENCH_VALUES;
+	uint32_t cycles_per_us = SystemCoreClock / 1000000;
+	uint32_t overhead = 0xFFFFFFFF;
+
+	for (uint8_t run = 0; run < DELAY_BENCH_RUNS; run++) {
+		uint32_t start = bench_cycles();
+		uint32_t cycles = bench_cycles() - start;
+		if (cycles < overhead) overhead = cycles;
+	}
+
+	for (uint8_t i = 0; i < DELAY_BENCH_COUNT; i++) {
+		struct Delay_result* result = &delay_results[i];
+		result->requested = values[i];
+		result->min_ns = 0xFFFFFFFF;
+		result->max_ns = 0;
+		for (uint8_t run = 0; run < DELAY_BENCH_RUNS; run++) {
+			uint32_t start = bench_cycles();
+			uint32_t ns;
+			delayUs(values[i]);
+			ns = (bench_cycles() - start - overhead) * 1000 / cycles_per_us;
+			if (ns < result->min_ns) result->min_ns = ns;
+			if (ns > result->max_ns) result->max_ns = ns;
+		}
+	}
+#endif
+}
@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file           : event_queue.c
+  * @brief          : Implements a single producer single consumer queue for
+  * 				  events of the interrupts
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "event_queue.h"
+
+/* Used for the timestamps of the events -------------------------------------*/
+#include "scheduler.h"
+
+/* Statistics of the queue ---------------------------------------------------*/
+struct Event_stats event_stats;
+
+/*
+ * Ring buffer of the events. head is only written by the producer, tail only
+ * by the consumer, both count up freely and wrap at 256, so the queue is full
+ * when they are EVENT_QUEUE_SIZE apart. Byte accesses are atomic on the M0.
+ */
+struct Event events[EVENT_QUEUE_SIZE];
+volatile uint8_t event_head = 0;
+volatile uint8_t event_tail = 0;
+
+/**
+  * @brief Adds an event with the current time to the queue. Has to be called
+  * 	   from interrupts of one priority only, e.g. the HAL callbacks.
+  * @param enum Event_type type interrupt the event comes from
+  * @param uint16_t data depends on type, the ADC value for Event_humidity
+  * @retval uint8_t TRUE if added, FALSE if the queue was full and the event was dropped
+  */
+uint8_t event_post(enum Event_type type, uint16_t data) {
+	uint8_t head = event_head;
+	uint8_t fill = head - event_tail;
+	struct Event* event = &events[head & (EVENT_QUEUE_SIZE - 1)];
+
+	event_stats.posted++;
+	if (fill >= EVENT_QUEUE_SIZE) {
+		event_stats.overflows++;
+		return FALSE;
+	}
+	event->time_us = scheduler_now_us();
+	event->data = data;
+	event->type = type;
+	__DMB();										// event is written before the consumer sees it
+	event_head = head + 1;
+
+	if (fill + 1 > event_stats.high_water) event_stats.high_water = fill + 1;
+	return TRUE;
+}
+
+/**
+  * @brief Takes the oldest event from the queue. Has to be called from the
+  * 	   main loop only.
+  * @param struct Event* event is set to the oldest event, only if there was one
+  * @retval uint8_t TRUE if event was set, FALSE if the queue is empty
+  */
+uint8_t event_get(struct Event* event) {
+	uint8_t tail = event_tail;
+	uint32_t wait_us;
+
+	if (tail == event_head) return FALSE;
+	__DMB();										// event is read after its head was seen
+	*event = events[tail & (EVENT_QUEUE_SIZE - 1)];
+	__DMB();										// event is copied before the producer may reuse it
+	event_tail = tail + 1;
+
+	wait_us = scheduler_now_us() - event->time_us;
+	if (wait_us > event_stats.max_wait_us) event_stats.max_wait_us = wait_us;
+	return TRUE;
+}
+
+/**
+  * @brief Tells if events are waiting, e.g. before the main loop idles.
+  * @retval uint8_t TRUE if the queue isn't empty
+  */
+uint8_t event_pending() {
+	return event_tail != event_head;
+}
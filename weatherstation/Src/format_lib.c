@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file           : format_lib.c
+  * @brief          : Implements Functions to format display fields without sprintf()
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "format_lib.h"
+
+/**
+  * @brief Copies a text.
+  * @param char* dst buffer to write to
+  * @param const char* text zero terminated text, the zero isn't copied
+  * @retval char* position behind the text
+  */
+char* format_text(char* dst, const char* text) {
+	while (*text) *dst++ = *text++;
+	return dst;
+}
+
+/**
+  * @brief Writes a number with as many digits as needed, like %d.
+  * @param char* dst buffer to write to, up to 5 chars
+  * @param uint16_t value number to write
+  * @retval char* position behind the number
+  */
+char* format_uint(char* dst, uint16_t value) {
+	char digits[5];
+	uint8_t count = 0;
+
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+	while (count) *dst++ = digits[--count];
+	return dst;
+}
+
+/**
+  * @brief Writes a number with 2 digits and leading zero, like %02d.
+  * @param char* dst buffer to write to
+  * @param uint8_t value number to write, 0 to 99
+  * @retval char* position behind the number
+  */
+char* format_2digits(char* dst, uint8_t value) {
+	dst[0] = '0' + value / 10;
+	dst[1] = '0' + value % 10;
+	return dst + 2;
+}
+
+/**
+  * @brief Writes a time as HH:MM:SS.
+  * @param char* dst buffer to write to, 8 chars
+  * @param uint8_t hours hours
+  * @param uint8_t minutes minutes
+  * @param uint8_t seconds seconds
+  * @retval char* position behind the time
+  */
+char* format_time(char* dst, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+	dst = format_2digits(dst, hours);
+	*dst++ = ':';
+	dst = format_2digits(dst, minutes);
+	*dst++ = ':';
+	return format_2digits(dst, seconds);
+}
+
+/**
+  * @brief Writes a temperature with sign (space if positive), one decimal and
+  * 	   unit, e.g. " 21.5°C" or "-3.0°C".
+  * @param char* dst buffer to write to, up to 8 chars
+  * @param int16_t temperature temperature in degrees C * 10
+  * @retval char* position behind the unit
+  */
+char* format_temperature(char* dst, int16_t temperature) {
+	uint16_t magnitude = (temperature < 0 ? -temperature : temperature);
+
+	*dst++ = (temperature < 0 ? '-' : ' ');
+	dst = format_uint(dst, magnitude / 10);
+	*dst++ = '.';
+	*dst++ = '0' + magnitude % 10;
+	*dst++ = DEGREE_SIGN;
+	*dst++ = 'C';
+	return dst;
+}
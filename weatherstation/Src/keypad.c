@@ -0,0 +1,172 @@
+/**
+  ******************************************************************************
+  * @file           : keypad.c
+  * @brief          : Implements Functions to scan and debounce the 4x4 keypad
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "keypad.h"
+
+/* Used for the timestamps of the latency measurement ------------------------*/
+#include "scheduler.h"
+
+/*
+ * Columns are outputs, the active one is driven high. Rows are inputs with
+ * pull down, so a pressed key in the active column reads high. Their rising
+ * edges only wake the core, keys are read by keypad_scan().
+ */
+const uint16_t col_pins[4] = {col0_Pin, col1_Pin, col2_Pin, col3_Pin};
+GPIO_TypeDef* const col_ports[4] = {col0_GPIO_Port, col1_GPIO_Port, col2_GPIO_Port, col3_GPIO_Port};
+const uint16_t row_pins[4] = {row0_INT_Pin, row1_INT_Pin, row2_INT_Pin, row3_INT_Pin};
+GPIO_TypeDef* const row_ports[4] = {row0_INT_GPIO_Port, row1_INT_GPIO_Port, row2_INT_GPIO_Port, row3_INT_GPIO_Port};
+
+/* Event counts and latencies ------------------------------------------------*/
+struct Keypad_stats keypad_stats;
+
+/*
+ * State of the scan and of every key. A key changes its debounced state after
+ * it was read differently by KEYPAD_DEBOUNCE scans in a row.
+ */
+void (*key_handler)(uint8_t key, enum Key_event event) = NULL;
+uint8_t active_col = 0;						// column driven high since the last scan
+uint16_t keys_pressed = 0;					// debounced state, bit per key
+uint8_t debounce[KEYPAD_KEYS];				// scans the key was read differently
+uint8_t hold[KEYPAD_KEYS];					// scans the key was held, till KEYPAD_LONG + KEYPAD_REPEAT
+uint32_t change_us[KEYPAD_KEYS];			// scheduler_now_us() of the first differing scan
+uint32_t press_us = 0;						// change_us of the last press not shown yet
+uint8_t press_waiting = FALSE;				// TRUE until keypad_shown() is called for it
+
+/* Private prototypes --------------------------------------------------------*/
+void sample_key(uint8_t key, uint8_t raw);
+void emit(uint8_t key, enum Key_event event);
+
+/**
+  * @brief Sets the handler of the key events and drives the first column.
+  * 	   The handler is called by keypad_scan(), it may take its time, the
+  * 	   scan of the next column waits for it.
+  * @param void (*handler)(uint8_t key, enum Key_event event) called with KEY(row, col) of the key
+  * @retval None
+  */
+void keypad_init(void (*handler)(uint8_t key, enum Key_event event)) {
+	key_handler = handler;
+	for (uint8_t i = 0; i < 4; i++) HAL_GPIO_WritePin(col_ports[i], col_pins[i], GPIO_PIN_RESET);
+	active_col = 0;
+	HAL_GPIO_WritePin(col_ports[active_col], col_pins[active_col], GPIO_PIN_SET);
+}
+
+/**
+  * @brief Task that reads the rows of the active column and drives the next one.
+  * 	   The rows had a whole period to settle. Each key is read every fourth call.
+  * @retval uint8_t TRUE, done
+  */
+uint8_t keypad_scan() {
+	for (uint8_t row = 0; row < 4; row++) {
+		sample_key(KEY(row, active_col), HAL_GPIO_ReadPin(row_ports[row], row_pins[row]) == GPIO_PIN_SET);
+	}
+	HAL_GPIO_WritePin(col_ports[active_col], col_pins[active_col], GPIO_PIN_RESET);
+	active_col = (active_col + 1) % 4;
+	HAL_GPIO_WritePin(col_ports[active_col], col_pins[active_col], GPIO_PIN_SET);
+	return TRUE;
+}
+
+/**
+  * @brief Debounces one reading of a key and emits its events. A held key emits
+  * 	   Key_long after KEYPAD_LONG scans, then Key_repeat every KEYPAD_REPEAT scans.
+  * @param uint8_t key KEY(row, col) of the key
+  * @param uint8_t raw TRUE if the key was read pressed
+  * @retval None
+  */
+void sample_key(uint8_t key, uint8_t raw) {
+	uint16_t mask = 1 << key;
+	uint8_t pressed = (keys_pressed & mask) != 0;
+
+	if (raw == pressed) {
+		if (debounce[key]) keypad_stats.bounces++;		// changed back before it counted
+		debounce[key] = 0;
+		if (!pressed) return;
+		if (++hold[key] == KEYPAD_LONG) {
+			emit(key, Key_long);
+		} else if (hold[key] == KEYPAD_LONG + KEYPAD_REPEAT) {
+			hold[key] = KEYPAD_LONG;
+			emit(key, Key_repeat);
+		}
+		return;
+	}
+
+	if (debounce[key]++ == 0) change_us[key] = scheduler_now_us();
+	if (debounce[key] < KEYPAD_DEBOUNCE) return;
+
+	debounce[key] = 0;
+	hold[key] = 0;
+	keys_pressed ^= mask;
+	if (raw) {
+		press_us = change_us[key];
+		press_waiting = TRUE;
+		emit(key, Key_press);
+	} else {
+		emit(key, Key_release);
+	}
+}
+
+/**
+  * @brief Counts an event and hands it to the handler.
+  * @param uint8_t key KEY(row, col) of the key
+  * @param enum Key_event event what happened to the key
+  * @retval None
+  */
+void emit(uint8_t key, enum Key_event event) {
+	keypad_stats.events[event]++;
+	if (key_handler) key_handler(key, event);
+}
+
+/**
+  * @brief Tells if no key is held or being debounced, so the scan may pause.
+  * @retval uint8_t TRUE if the keypad is idle
+  */
+uint8_t keypad_idle() {
+	if (keys_pressed) return FALSE;
+	for (uint8_t i = 0; i < KEYPAD_KEYS; i++) {
+		if (debounce[i]) return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+  * @brief Has to be called when the display shows the result of the last key
+  * 	   press. Records the time since the first scan that read the key. The
+  * 	   key was pressed up to one scan of all columns before.
+  * @retval None
+  */
+void keypad_shown() {
+	if (!press_waiting) return;
+	press_waiting = FALSE;
+	keypad_stats.last_latency_us = scheduler_now_us() - press_us;
+	if (keypad_stats.last_latency_us > keypad_stats.max_latency_us) {
+		keypad_stats.max_latency_us = keypad_stats.last_latency_us;
+	}
+}
+
+/**
+  * @brief Drives all columns before Stop mode, so any key raises its row and
+  * 	   wakes the core by EXTI. Called with interrupts disabled.
+  * @retval None
+  */
+void keypad_park() {
+	for (uint8_t i = 0; i < 4; i++) HAL_GPIO_WritePin(col_ports[i], col_pins[i], GPIO_PIN_SET);
+}
+
+/**
+  * @brief Drives only the active column again after Stop mode. A key that woke
+  * 	   the core is read by the next scans. Called with interrupts disabled.
+  * @retval None
+  */
+void keypad_resume() {
+	for (uint8_t i = 0; i < 4; i++) {
+		HAL_GPIO_WritePin(col_ports[i], col_pins[i], i == active_col ? GPIO_PIN_SET : GPIO_PIN_RESET);
+	}
+}
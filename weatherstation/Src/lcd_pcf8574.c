@@ -0,0 +1,210 @@
+/**
+  ******************************************************************************
+  * @file           : lcd_pcf8574.c
+  * @brief          : Implements Functions to drive the display through a
+  * 				  PCF8574 I2C expander backpack
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+#include "lcd_pcf8574.h"
+
+#ifdef LCD_I2C
+
+/*
+ * Wiring of the common backpacks: P0 RS, P1 R/W, P2 E, P3 backlight,
+ * P4-P7 DB4-DB7. The display runs in 4 bit mode, R/W is always low.
+ * Every nibble is two expander writes, E high with the nibble and E low
+ * with the nibble, the display takes the nibble on the falling edge.
+ */
+
+/* Pins of the expander --------------------------------------------------------*/
+#define PCF_RS				0x01
+#define PCF_E				0x04
+#define PCF_BACKLIGHT		0x08
+
+/* Expander writes per display byte, E high and low for both nibbles -------------*/
+#define WRITES_PER_BYTE		4
+
+/*
+ * One expander write is 9 bit times, 90 us at 100 kHz, so a display byte
+ * takes 360 us and the execution time of 37 us has passed before the next one.
+ * CLEAR_DISPLAY and HOME need 1.52 ms, they are followed by writes that only
+ * keep the backlight on.
+ */
+#define WRITE_NS			(9UL * 1000000 / (LCD_I2C_SPEED / 1000))
+#define CLEAR_PADDING		((1520000 + WRITE_NS - 1) / WRITE_NS)	// 17 * 90 us = 1.53 ms at 100 kHz
+
+/* Display bytes per batch, every cell with its own address jump fits -----------*/
+#define BATCH_BYTES			(2 * LCD_ROWS * LCD_COLS)
+#define BATCH_SIZE			(BATCH_BYTES * WRITES_PER_BYTE)
+
+/* Timeout of blocking writes, a missing backpack doesn't hang the init --------*/
+#define I2C_TIMEOUT			10			// in ms
+
+/*
+ * I2C handle and DMA channel, I2C1 TX is served by channel 2.
+ */
+I2C_HandleTypeDef* lcd_hi2c;
+DMA_HandleTypeDef hdma_i2c1_tx;
+
+/*
+ * Expander writes of the display bytes queued since the last transfer. The
+ * whole batch is sent by one I2C transaction, nothing is added while it runs.
+ */
+uint8_t batch[BATCH_SIZE];
+uint16_t batch_length = 0;					// expander writes in batch
+volatile uint8_t batch_sending = FALSE;		// TRUE while DMA moves the batch
+volatile uint8_t batch_failed = FALSE;		// TRUE if a batch was dropped since lcd_i2c_failed()
+uint16_t lcd_i2c_errors = 0;				// transfers that were not acknowledged
+
+/* Private prototypes --------------------------------------------------------*/
+uint8_t* pack_byte(uint8_t* out, uint8_t byte, uint8_t data);
+
+/**
+  * @brief Sets up the DMA channel for I2C1 TX and switches the backlight on.
+  * 	   Has to be called once after the I2C was initialized by CubeMX code and
+  * 	   before init_display().
+  * @param I2C_HandleTypeDef* hi2c I2C1 handle, the backpack is connected to it
+  * @retval None
+  */
+void lcd_i2c_init(I2C_HandleTypeDef* hi2c) {
+	uint8_t backlight = PCF_BACKLIGHT;
+
+	lcd_hi2c = hi2c;
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	hdma_i2c1_tx.Instance = DMA1_Channel2;
+	hdma_i2c1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_i2c1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_i2c1_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_i2c1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_i2c1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_i2c1_tx.Init.Mode = DMA_NORMAL;
+	hdma_i2c1_tx.Init.Priority = DMA_PRIORITY_LOW;
+	HAL_DMA_Init(&hdma_i2c1_tx);
+	__HAL_LINKDMA(hi2c, hdmatx, hdma_i2c1_tx);
+
+	/* Same priority as the display timer */
+	HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+
+	HAL_I2C_Master_Transmit(lcd_hi2c, LCD_I2C_ADDRESS << 1, &backlight, 1, I2C_TIMEOUT);
+}
+
+/**
+  * @brief Writes the expander states that clock a byte into the display.
+  * @param uint8_t* out first of WRITES_PER_BYTE expander writes
+  * @param uint8_t byte instruction or data byte
+  * @param uint8_t data TRUE for data (RS high), FALSE for an instruction
+  * @retval uint8_t* write after the last one written
+  */
+uint8_t* pack_byte(uint8_t* out, uint8_t byte, uint8_t data) {
+	uint8_t control = PCF_BACKLIGHT | (data ? PCF_RS : 0);
+	uint8_t high = (byte & 0xF0) | control;
+	uint8_t low = (uint8_t) (byte << 4) | control;
+
+	*out++ = high | PCF_E;
+	*out++ = high;
+	*out++ = low | PCF_E;
+	*out++ = low;
+	return out;
+}
+
+/**
+  * @brief Sends a byte to the display. Blocking, ~400 us at 100 kHz.
+  * 	   Only used before display_start_async().
+  * @param uint8_t byte instruction or data byte
+  * @param uint8_t data TRUE for data (RS high), FALSE for an instruction
+  * @retval None
+  */
+void lcd_i2c_write(uint8_t byte, uint8_t data) {
+	uint8_t writes[WRITES_PER_BYTE];
+
+	pack_byte(writes, byte, data);
+	if (HAL_I2C_Master_Transmit(lcd_hi2c, LCD_I2C_ADDRESS << 1, writes, WRITES_PER_BYTE, I2C_TIMEOUT) != HAL_OK) {
+		lcd_i2c_errors++;
+	}
+}
+
+/**
+  * @brief Adds a byte to the batch. It's sent by the next lcd_i2c_send().
+  * @param uint8_t byte instruction or data byte
+  * @param uint8_t data TRUE for data (RS high), FALSE for an instruction
+  * @param uint8_t clear TRUE for CLEAR_DISPLAY and HOME, CLEAR_PADDING writes follow
+  * @retval uint8_t TRUE if added, FALSE if the batch is full or being sent
+  */
+uint8_t lcd_i2c_queue(uint8_t byte, uint8_t data, uint8_t clear) {
+	uint16_t length = WRITES_PER_BYTE + (clear ? CLEAR_PADDING : 0);
+	uint8_t* out = &batch[batch_length];
+
+	if (batch_sending || batch_length + length > BATCH_SIZE) return FALSE;
+	out = pack_byte(out, byte, data);
+	for (uint8_t i = WRITES_PER_BYTE; i < length; i++) *out++ = PCF_BACKLIGHT;
+	batch_length += length;
+	return TRUE;
+}
+
+/**
+  * @brief Returns the number of display bytes that still fit into the batch.
+  * @retval uint8_t free display bytes, 0 while the batch is sent
+  */
+uint8_t lcd_i2c_room() {
+	if (batch_sending) return 0;
+	return (BATCH_SIZE - batch_length) / WRITES_PER_BYTE;
+}
+
+/**
+  * @brief Sends the batch by DMA as one I2C transaction and returns immediately.
+  * 	   Does nothing if the batch is empty or already being sent.
+  * @retval None
+  */
+void lcd_i2c_send() {
+	if (batch_sending || batch_length == 0) return;
+	batch_sending = TRUE;
+	if (HAL_I2C_Master_Transmit_DMA(lcd_hi2c, LCD_I2C_ADDRESS << 1, batch, batch_length) != HAL_OK) {
+		lcd_i2c_transfer_complete(TRUE);
+	}
+}
+
+/**
+  * @brief Tells if the last batch was sent.
+  * @retval uint8_t TRUE if no transfer is running
+  */
+uint8_t lcd_i2c_idle() {
+	return !batch_sending;
+}
+
+/**
+  * @brief Has to be called by the I2C master TX complete and error callbacks.
+  * 	   Empties the batch, a failed batch is dropped and reported by
+  * 	   lcd_i2c_failed(). Called in interrupt context.
+  * @param uint8_t error TRUE if the transfer failed
+  * @retval None
+  */
+void lcd_i2c_transfer_complete(uint8_t error) {
+	if (error) {
+		lcd_i2c_errors++;
+		batch_failed = TRUE;
+	}
+	batch_length = 0;
+	batch_sending = FALSE;
+}
+
+/**
+  * @brief Tells if a batch was dropped since the last call, the display
+  * 	   doesn't show what was queued then.
+  * @retval uint8_t TRUE if a batch failed
+  */
+uint8_t lcd_i2c_failed() {
+	uint8_t failed = batch_failed;
+
+	batch_failed = FALSE;
+	return failed;
+}
+
+#endif /* LCD_I2C */
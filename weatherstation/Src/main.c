@@ -25,6 +25,10 @@
 /* USER CODE BEGIN Includes */
 #include "onewire_DS1820.h"		// Onewire library for DS1820
 #include "LCD_2x16.h"			// library for the display
+#include "scheduler.h"			// periodic tasks of the main loop
+#include "power.h"				// Sleep and Stop mode between the tasks
+#include "event_queue.h"		// events of the interrupts for the main loop
+#include "keypad.h"				// debounced 4x4 keypad
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -35,12 +39,23 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 /*
- * Defines that configure the delays between tasks.
+ * Defines that configure the periods of the tasks, in TIM6 ticks.
  */
-#define READYTOCALLFUNC 	80	// TOCALLFUNC * 6,25ms =  time between outputs
+#define KEYPADSCAN			1	// KEYPADSCAN * 6,25ms = time between keypad column changes
 #define DISPLAYUPDATE 		80	// DISPLAYUPDATE * 6,25ms = time between display updates
 #define MEASUREMENT			80  // MEASUREMENT * 6,25ms = time between measurements
 #define TOOGLEMODE			800 // TOOGLEMODE * 6,25ms = time between alternations in view mode toggle
+#define HISTORY_SAMPLE		60	// HISTORY_SAMPLE * MEASUREMENT = time between samples of the sparkline
+
+/*
+ * Age in ms after which the temperature is marked as stale on the display.
+ * Pipelined readings are one MEASUREMENT period old, so allow missing two of them.
+ */
+#define TEMPERATURE_STALE	1500
+/*
+ * Age in ms after which the temperature isn't shown anymore.
+ */
+#define TEMPERATURE_MISSING	5000
 
 /* USER CODE END PD */
 
@@ -52,61 +67,31 @@
 /* Private variables ---------------------------------------------------------*/
 ADC_HandleTypeDef hadc;
 
+I2C_HandleTypeDef hi2c1;
+
 RTC_HandleTypeDef hrtc;
 
 TIM_HandleTypeDef htim6;
+TIM_HandleTypeDef htim16;
+TIM_HandleTypeDef htim17;
 
 UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN PV */
 /*
- * Arrays to iterate and choose port and pin from to toggle depending on colCounter
- * for multiplexing in 4x4 keypad.
+ * Flags used to measure the key to display latency.
+ * 	- key_update = TRUE				a key function was called, display isn't updated yet
+ * 	- key_update_sending = TRUE		update is queued, display hasn't received it yet
  */
-uint16_t GPIO_PINS[4] = {col0_Pin, col1_Pin, col2_Pin, col3_Pin};
-GPIO_TypeDef* GPIO_PORTS[4] = {col0_GPIO_Port, col1_GPIO_Port, col2_GPIO_Port, col3_GPIO_Port};
+uint8_t key_update = FALSE;
+uint8_t key_update_sending = FALSE;
 
 /*
- * colCounter is used to track the currently active column on 4x4 keypad.
- */
-uint16_t colCounter = 0;
-
-/*
- * Used to determine if in next step of multiplexing, column pin has to be set or reset.
- */
-uint16_t current_Port_active = FALSE;
-
-/*
- * Declaration of functionpointer to be called, when call_counter reached READYTOCALLFUNC
- * And default function pointer to reset after function was called.
- */
-void (*func_to_call_next_ptr)();
-void (*default_func_ptr)();
-
-/*
- * Counter which are incremented by main timer to implemented different delays for different tasks.
- * When a timer reached it's corresponding threshold given by defines. A flag is set.
- */
-uint16_t call_counter = 0;							// used for function call, selected by keypad
-uint16_t display_counter = 0;						// used for display updates
-uint16_t measurement_counter = 0;					// used for measurements
-uint16_t toggle_view_mode_counter = 0;				// used to change view in toggle view mode
-
-/*
- * Flags used in main loop to handle tasks when a specific delay for each operation is reached.
- * If flag is TRUE, operation is executed in current iteration.
+ * Flag used in main loop.
  * Initialized for correct starting behaviour.
- * 	- call_func = FALSE					no key was pressed yet
- * 	- update_display = TRUE 			update display so initial Time_conf mode is displayed
- * 	- update_measurement = TRUE			get first measurment
  * 	- change_toggle_view_mode = TRUE 	start toggling view mode when toggle view mode is selected
- * 	- ready_to_calc_humidity = FALSE	no value received from adc yet
  */
-uint8_t call_func = FALSE;
-uint8_t update_display = TRUE;
-uint8_t update_measurment = TRUE;
 uint8_t change_toggle_view_mode = TRUE;
-uint8_t ready_to_calc_humidity = FALSE;
 
 /*
  * Flag used to prevent time updates while the Time_conf mode is displayed.
@@ -137,10 +122,19 @@ RTC_TimeTypeDef gTime = {0};;
 int16_t current_temperature = 0;
 
 /*
- * Stores for humidity value received by ADC in humidity_uncalculated.
- * humidity_calculated stores the percentage after calculations.
+ * Tells the display if current_temperature is too old to be trusted.
+ */
+enum Temp_state current_temp_state = Temp_valid;
+
+/*
+ * Counts completed temperature readings, every HISTORY_SAMPLE one is added
+ * to the history of the Temp_history view.
+ */
+uint16_t history_counter = 0;
+
+/*
+ * humidity_calculated stores the percentage calculated from the last ADC value.
  */
-uint32_t humidity_uncalculated = 0;
 uint16_t humidity_calculated = 0;
 /* USER CODE END PV */
 
@@ -151,6 +145,9 @@ static void MX_TIM6_Init(void);
 static void MX_RTC_Init(void);
 static void MX_ADC_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_TIM16_Init(void);
+static void MX_TIM17_Init(void);
+static void MX_I2C1_Init(void);
 /* USER CODE BEGIN PFP */
 void get_time();
 void select_next_time_frac();
@@ -163,6 +160,13 @@ void nop();
 void change_timeformat();
 void exit_time_conf();
 uint16_t calculateHumidity(uint32_t uncalc_value);
+void handle_event(struct Event* event);
+void handle_key(uint8_t key, enum Key_event event);
+uint8_t task_measurement();
+uint8_t task_display();
+uint8_t task_toggle_view();
+uint8_t stop_allowed();
+void wake_from_stop();
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -287,7 +291,7 @@ void inc_currently_selected(void) {
 	case None_sel: {
 		break;
 	}
-	write_to_display(humidity_calculated, current_temperature, gTime, current_mode, current_selected, change_toggle_view_mode);
+	write_to_display(humidity_calculated, current_temperature, current_temp_state, gTime, current_mode, current_selected, change_toggle_view_mode);
 	}
 }
 
@@ -324,7 +328,7 @@ void dec_currently_selected(void) {
 	case None_sel: {
 		break;
 	}
-	write_to_display(humidity_calculated, current_temperature, gTime, current_mode, current_selected, change_toggle_view_mode);
+	write_to_display(humidity_calculated, current_temperature, current_temp_state, gTime, current_mode, current_selected, change_toggle_view_mode);
 	}
 }
 
@@ -354,6 +358,17 @@ void (*funcs[4][4])(void) = {
 		{nop,			 			nop,			   			nop,  					change_timeformat}
 };
 
+/*
+ * Keys whose function is called again while they are held, like funcs. Held
+ * longer than KEYPAD_LONG, they repeat every KEYPAD_REPEAT scans.
+ */
+const uint8_t repeats[4][4] = {
+		{FALSE,	TRUE,	FALSE,	FALSE},
+		{FALSE,	FALSE,	FALSE,	FALSE},
+		{FALSE,	TRUE,	FALSE,	FALSE},
+		{FALSE,	FALSE,	FALSE,	FALSE}
+};
+
 /**
   * @brief Function used to calculate humidity dependent on the measured voltage at the potentiometer.
   * @param uint32_t uncalculated value from ADC.
@@ -363,6 +378,122 @@ uint16_t calculateHumidity(uint32_t uncalc_value) {
 	return (100 * uncalc_value) >> 12;
 }
 
+/**
+  * @brief Handles an event of the interrupts, called by the main loop in the
+  * 		  order the events were posted.
+  * @param struct Event* event event taken from the queue
+  * @retval None
+  */
+void handle_event(struct Event* event) {
+	switch (event->type) {
+	case Event_humidity: {
+		humidity_calculated = calculateHumidity(event->data);	// calculate percentage
+		break;
+	}
+	}
+}
+
+/**
+  * @brief Handles the debounced key events, called by keypad_scan(). Calls the
+  * 		  function of a pressed key, of a held key only if it repeats, and
+  * 		  updates the display right away.
+  * @param uint8_t key KEY(row, col) of the key
+  * @param enum Key_event event what happened to the key
+  * @retval None
+  */
+void handle_key(uint8_t key, enum Key_event event) {
+	uint8_t row = KEY_ROW(key);
+	uint8_t col = KEY_COL(key);
+
+	if (event == Key_release) return;
+	if (event != Key_press && !repeats[row][col]) return;
+	(*funcs[row][col])();
+	key_update = TRUE;
+	scheduler_trigger(task_display);			// don't wait for the next periodic update
+}
+
+/**
+  * @brief Task that starts the humidity measurement and the next temperature
+  * 		  reading, results are collected by the main loop.
+  * @retval uint8_t TRUE, done
+  */
+uint8_t task_measurement() {
+	HAL_ADC_Start_IT(&hadc);						// Start ADC measurement in Interrupt mode
+	start_temperature_pipelined(NULL);			// Read last conversion of DS1820 and start the next one
+	return TRUE;
+}
+
+/**
+  * @brief Task that updates the display with the current time and measurements.
+  * @retval uint8_t TRUE if the update was queued, FALSE to retry when the queue has room
+  */
+uint8_t task_display() {
+	get_time();									// update the time
+	if (!is_device_present(0) || get_temperature_age() > TEMPERATURE_MISSING) current_temp_state = Temp_missing;
+	else if (get_temperature_age() > TEMPERATURE_STALE) current_temp_state = Temp_stale;
+	else current_temp_state = Temp_valid;
+	if (!write_to_display(humidity_calculated,	// queue for display, percentage humidity
+			current_temperature,					// current temperature
+			current_temp_state,						// if temperature is stale
+			gTime,									// struct that contains current time
+			current_mode,							// current display mode
+			current_selected,						// if Time_conf mode, selected time fraction
+			change_toggle_view_mode)) {				// if Toggle mode
+		return FALSE;
+	}
+	if (key_update) {								// result of the last key is on its way
+		key_update = FALSE;
+		key_update_sending = TRUE;
+	}
+	return TRUE;
+}
+
+/**
+  * @brief Task that alternates the views of the toggle view mode.
+  * @retval uint8_t TRUE, done
+  */
+uint8_t task_toggle_view() {
+	change_toggle_view_mode = !change_toggle_view_mode;
+	return TRUE;
+}
+
+/**
+  * @brief Tells if Stop mode may be entered. Clocks of timers, ADC, DMA and
+  * 		  I2C are stopped, so display transfer, 1wire reading and ADC
+  * 		  conversion have to be done. The keypad scan pauses, so no key
+  * 		  may be held.
+  * @retval uint8_t TRUE if no peripheral is busy
+  */
+uint8_t stop_allowed() {
+	return is_display_idle() && is_onewire_idle() && keypad_idle()
+			&& !(HAL_ADC_GetState(&hadc) & HAL_ADC_STATE_REG_BUSY);
+}
+
+/**
+  * @brief Restores the system clock and the keypad column of the scan after Stop
+  * 		  mode. Called with interrupts disabled.
+  * @retval None
+  */
+void wake_from_stop() {
+	SystemClock_Config();
+	keypad_resume();
+}
+
+/*
+ * Periodic tasks, run by scheduler_run() in table order. Period, phase and
+ * deadline are in TIM6 ticks. Measurement and display share a period,
+ * PHASE_AUTO spreads them over it: measurement starts right away, the display
+ * follows half a period later with fresh values. Key presses release the
+ * display once more. Toggling starts after a full period.
+ */
+const struct Task tasks[] = {
+	/* run					period				phase				deadline */
+	{keypad_scan,			KEYPADSCAN,			0,					KEYPADSCAN},
+	{task_measurement,		MEASUREMENT,		PHASE_AUTO,			MEASUREMENT},
+	{task_display,			DISPLAYUPDATE,		PHASE_AUTO,			DISPLAYUPDATE},
+	{task_toggle_view,		TOOGLEMODE,			TOOGLEMODE,			TOOGLEMODE}
+};
+
 /* USER CODE END 0 */
 
 /**
@@ -372,7 +503,7 @@ uint16_t calculateHumidity(uint32_t uncalc_value) {
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-
+  struct Event event;
   /* USER CODE END 1 */
   
 
@@ -398,50 +529,84 @@ int main(void)
   MX_RTC_Init();
   MX_ADC_Init();
   MX_USART2_UART_Init();
+  MX_TIM16_Init();
+  MX_TIM17_Init();
+  MX_I2C1_Init();
   /* USER CODE BEGIN 2 */
   /* Start main timer */
   HAL_TIM_Base_Start_IT(&htim6);
+  /* Free running timer for the us delays of display and 1wire */
+  delay_init();
+#ifdef LCD_I2C
+  /* Display is connected by a PCF8574 backpack on I2C1 */
+  lcd_i2c_init(&hi2c1);
+#endif
   /* Initialize the display */
   init_display();
-  /* Set default function to dummy */
-  default_func_ptr = nop;
-  /* No button was pressed initally. Set next function call to nop */
-  func_to_call_next_ptr = default_func_ptr;
-  /* Start ADC in Interrupt mode to get first measurment */
-  HAL_ADC_Start_IT(&hadc);
+#ifdef ONEWIRE_UART
+  /* 1wire bus is USART2 TX in half duplex mode */
+  onewire_uart_init(&huart2);
+#endif
+  /* Timer clocking the interrupt driven temperature readings */
+  onewire_init(&htim16);
+  /* Find all DS1820 on the bus, readings address them one after another */
+  search_devices();
+  /* Shorten conversion time of DS18B20, so it fits into the measurement period */
+  set_resolution(ONEWIRE_RESOLUTION);
+#ifdef BENCHMARK_ENABLED
+  /* Measure main loop blocking time of blocking and interrupt driven reading */
+  benchmark_temperature_reading();
+  /* Measure cycles of the CRC8 variants */
+  benchmark_crc8();
+  /* Measure requested vs actual us delays */
+  benchmark_delay();
+  /* Measure pin access with HAL and gpio_lib.h */
+  benchmark_pin_access();
+  benchmark_lcd();
+#endif
+  /* Display bytes are queued and sent by TIM17 from now on */
+  display_start_async(&htim17);
+  /* Keys are scanned column by column, their events call handle_key() */
+  keypad_init(handle_key);
+  /* Idle time is spent in Sleep or Stop mode, RTC alarm or keypad wake from Stop */
+  power_init(&hrtc, keypad_park, wake_from_stop);
+  /* Periodic tasks are released by TIM6 ticks from now on */
+  scheduler_init(&htim6, tasks, sizeof(tasks) / sizeof(tasks[0]));
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	  /* Delay for next function call ended, flag was set */
-	  if (call_func) {
-		  	(*func_to_call_next_ptr)();					// call function currently selected
-		  	func_to_call_next_ptr = default_func_ptr;	// reset pointer to default_func_ptr (nop)
-		  	call_func = FALSE;							// reset flag
-	  	}
-	  /* Delay for next measurement update ended, flag was set */
-	  if (update_measurment) {
-		  HAL_ADC_Start_IT(&hadc);						// Start ADC measurement in Interrupt mode
-		  current_temperature = get_temperature();		// Get temperature reading from DS1820
-		  update_measurment = FALSE;					// reset flag
+	  /* Run the periodic tasks that were released by TIM6 */
+	  scheduler_run();
+	  /* Temperature reading ended, result replaces current value if it is valid */
+	  if (poll_temperature()) {
+		  if (complete_temperature(&current_temperature) && ++history_counter >= HISTORY_SAMPLE) {
+			  add_temperature_history(current_temperature);
+			  history_counter = 0;
+		  }
 	  }
-	  /* ADC measurement ended, flag was set by ADC interrupt, percentage value may be calculated */
-	  if (ready_to_calc_humidity) {
-		  humidity_calculated = calculateHumidity(humidity_uncalculated);	// calculate percentage
-		  ready_to_calc_humidity = FALSE;									// reset flag
+	  /* DS1820 was plugged in again, find it and set its resolution */
+	  if (onewire_hotplug_poll()) {
+		  set_resolution(ONEWIRE_RESOLUTION);
 	  }
-	  /* Display update period ended, flag was set */
-	  if (update_display) {
-		  get_time();									// update the time
-		  write_to_display(humidity_calculated,			// send to display, percentage humidity
-				  current_temperature,					// current temperature
-				  gTime,								// struct that contains current time
-				  current_mode,							// current display mode
-				  current_selected,						// if Time_conf mode, selected time fraction
-				  change_toggle_view_mode);				// if Toggle mode
-		  update_display = FALSE;						// reset flag
+	  /* ADC results, posted by the interrupts */
+	  while (event_get(&event)) {
+		  handle_event(&event);
+	  }
+	  /* Display got the result of the last key, record the key to display latency */
+	  if (key_update_sending && is_display_idle()) {
+		  keypad_shown();
+		  key_update_sending = FALSE;
+	  }
+	  /* Nothing left to do, idle till the next release or interrupt. Interrupts are
+	   * disabled while checking, so an event can't get lost before the core idles */
+	  __disable_irq();
+	  if (event_pending() || poll_temperature()) {
+		  __enable_irq();
+	  } else {
+		  power_idle(scheduler_idle_us(0), stop_allowed() ? scheduler_idle_us(KEYPADSCAN + 1) : 0);
 	  }
 
     /* USER CODE END WHILE */
@@ -494,7 +659,8 @@ void SystemClock_Config(void)
   {
     Error_Handler();
   }
-  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_I2C1|RCC_PERIPHCLK_RTC;
+  PeriphClkInit.I2c1ClockSelection = RCC_I2C1CLKSOURCE_HSI;
   PeriphClkInit.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
   if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
   {
@@ -554,6 +720,52 @@ static void MX_ADC_Init(void)
 
 }
 
+/**
+  * @brief I2C1 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_I2C1_Init(void)
+{
+
+  /* USER CODE BEGIN I2C1_Init 0 */
+
+  /* USER CODE END I2C1_Init 0 */
+
+  /* USER CODE BEGIN I2C1_Init 1 */
+
+  /* USER CODE END I2C1_Init 1 */
+  hi2c1.Instance = I2C1;
+  hi2c1.Init.Timing = 0x2000090E;
+  hi2c1.Init.OwnAddress1 = 0;
+  hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+  hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+  hi2c1.Init.OwnAddress2 = 0;
+  hi2c1.Init.OwnAddress2Masks = I2C_OA2_NOMASK;
+  hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+  hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+  if (HAL_I2C_Init(&hi2c1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /** Configure Analogue filter 
+  */
+  if (HAL_I2CEx_ConfigAnalogFilter(&hi2c1, I2C_ANALOGFILTER_ENABLE) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /** Configure Digital filter 
+  */
+  if (HAL_I2CEx_ConfigDigitalFilter(&hi2c1, 0) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN I2C1_Init 2 */
+
+  /* USER CODE END I2C1_Init 2 */
+
+}
+
 /**
   * @brief RTC Initialization Function
   * @param None
@@ -646,6 +858,70 @@ static void MX_TIM6_Init(void)
 
 }
 
+/**
+  * @brief TIM16 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM16_Init(void)
+{
+
+  /* USER CODE BEGIN TIM16_Init 0 */
+
+  /* USER CODE END TIM16_Init 0 */
+
+  /* USER CODE BEGIN TIM16_Init 1 */
+
+  /* USER CODE END TIM16_Init 1 */
+  htim16.Instance = TIM16;
+  htim16.Init.Prescaler = 47;
+  htim16.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim16.Init.Period = 65535;
+  htim16.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim16.Init.RepetitionCounter = 0;
+  htim16.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim16) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM16_Init 2 */
+
+  /* USER CODE END TIM16_Init 2 */
+
+}
+
+/**
+  * @brief TIM17 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM17_Init(void)
+{
+
+  /* USER CODE BEGIN TIM17_Init 0 */
+
+  /* USER CODE END TIM17_Init 0 */
+
+  /* USER CODE BEGIN TIM17_Init 1 */
+
+  /* USER CODE END TIM17_Init 1 */
+  htim17.Instance = TIM17;
+  htim17.Init.Prescaler = 47;
+  htim17.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim17.Init.Period = 65535;
+  htim17.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim17.Init.RepetitionCounter = 0;
+  htim17.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim17) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM17_Init 2 */
+
+  /* USER CODE END TIM17_Init 2 */
+
+}
+
 /**
   * @brief USART2 Initialization Function
   * @param None
@@ -759,72 +1035,46 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 /**
- * @brief EXTI line detection callbacks.
- * @param GPIO_PIN: Specifies the pins connected EXTI line
+ * @brief TIM Period Elapsed Callback handler.
+ * @param *htim: Timer interrupt source
  * @retval None
  */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-	switch(GPIO_Pin) {
-		case row0_INT_Pin: {
-			func_to_call_next_ptr = funcs[0][colCounter];
-			} break;
-		case row1_INT_Pin: {
-			func_to_call_next_ptr = funcs[1][colCounter];
-			} break;
-		case row2_INT_Pin: {
-			func_to_call_next_ptr = funcs[2][colCounter];
-			} break;
-		case row3_INT_Pin: {
-			func_to_call_next_ptr = funcs[3][colCounter];
-		} break;
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+	if (htim == &htim6) {
+		/* Next tick of the periodic tasks, they are run by the main loop */
+		scheduler_tick();
+	}
+	if (htim == &htim17) {
+		/* Next nibble of the queued display bytes */
+		display_timer_tick();
+	}
+	if (htim == &htim16) {
+		/* Next step of the interrupt driven temperature reading */
+		onewire_timer_tick();
 	}
 }
 
-
+#ifdef LCD_I2C
 /**
- * @brief TIM Period Elapsed Callback handler.
- * @param *htim: Timer interrupt source
+ * @brief Handler for I2C master transmit complete callback.
+ * @param *hi2c: I2C interrupt source
  * @retval None
  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
-	if (htim == &htim6) {
-		/* Setting flags for next main loop iteration and reset counter */
-		if (call_counter == READYTOCALLFUNC) {
-			call_func = TRUE;
-			call_counter = 0;
-		}
-		if (display_counter == DISPLAYUPDATE) {
-			update_display = TRUE;
-			display_counter = 0;
-		}
-		if (measurement_counter == MEASUREMENT) {
-			update_measurment = TRUE;
-			measurement_counter = 0;
-		}
-		if (toggle_view_mode_counter == TOOGLEMODE) {
-			if (change_toggle_view_mode == TRUE) {
-				change_toggle_view_mode = FALSE;
-			} else {
-				change_toggle_view_mode = TRUE;
-			}
-			toggle_view_mode_counter = 0;
-		}
-		/* Increment all counter */
-		call_counter++;
-		display_counter++;
-		measurement_counter++;
-		toggle_view_mode_counter++;
-		/* Toggle Pin for multiplexing */
-		HAL_GPIO_TogglePin(GPIO_PORTS[colCounter], GPIO_PINS[colCounter]);
-		if (current_Port_active) {
-			current_Port_active = FALSE;
-			colCounter = (colCounter + 1) % 4;
-		} else {
-			current_Port_active = TRUE;
-		}
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+	/* Batch of display bytes was sent */
+	lcd_i2c_transfer_complete(FALSE);
+}
 
-	}
+/**
+ * @brief Handler for I2C error callback.
+ * @param *hi2c: I2C interrupt source
+ * @retval None
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+	/* Backpack didn't acknowledge, batch of display bytes is dropped */
+	lcd_i2c_transfer_complete(TRUE);
 }
+#endif
 
 /**
  * @brief Handler for ADC conversion complete callback.
@@ -832,10 +1082,8 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
  * @retval None
  */
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
-	/* Store value in global */
-	humidity_uncalculated = HAL_ADC_GetValue(hadc);
-	/* Set flag, so percentage is calculated in next main loop iteration */
-	ready_to_calc_humidity = TRUE;
+	/* Percentage is calculated by the main loop */
+	event_post(Event_humidity, HAL_ADC_GetValue(hadc));
 }
 
 /* USER CODE END 4 */
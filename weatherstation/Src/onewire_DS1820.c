@@ -13,9 +13,24 @@
 #include "onewire_DS1820.h"
 
 /* Commands for DS1820 -------------------------------------------------------*/
+#define SEARCH_ROM			0xF0
+#define ALARM_SEARCH		0xEC
+#define MATCH_ROM			0x55
 #define SKIP_ROM 			0xCC
 #define CONVERT_T 			0x44
 #define READ_SCRATCHPAD		0xBE
+#define WRITE_SCRATCHPAD	0x4E
+#define COPY_SCRATCHPAD		0x48
+
+/* Family codes, first byte of the ROM code ----------------------------------*/
+#define FAMILY_DS18S20		0x10
+#define FAMILY_DS18B20		0x28
+#define FAMILY_DS1822		0x22
+
+/* Conversion times in ms ----------------------------------------------------*/
+#define CONVERSION_TIME_MAX		750		// DS18S20 and DS18B20 with 12 bit, halves per bit less
+#define COPY_TIME				10		// COPY SCRATCHPAD to EEPROM
+#define CONVERSION_TIMEOUT(time)	((time) + (time) / 4)	// conversion time plus 25 % margin
 
 /* Time definitions in us ----------------------------------------------------*/
 #define RESET					500
@@ -23,17 +38,269 @@
 #define SEND_SHORT				5
 #define READ_LOW				1
 #define READ_WAIT				10
+#define READ_RECOVER			50
+#define PRESENCE_WAIT			70
+#define PRESENCE_RECOVER		410
+#define CONVERSION_POLL			1000	// time between read slots once conversion should be done
+#define TIMER_WAIT_MAX			50000	// longest wait for a single timer period
+#define RETRY_BACKOFF			1000	// pause before re-reading a scratchpad, times retry number
+#define READ_SLOT				(READ_LOW + READ_WAIT + READ_RECOVER)
+#define RESET_SLOT				(RESET + PRESENCE_WAIT + PRESENCE_RECOVER)
+
+/* Returned by process_step() if the UART transport calls back when done ------*/
+#define WAIT_TRANSFER			0xFFFF
+
+/* Re-reads of a scratchpad with wrong CRC, before the device is given up -----*/
+#define MAX_RETRIES				3
+
+/* Repeats of a SEARCH ROM pass with a bus error, before the search is given up */
+#define SEARCH_RETRIES			3
+
+/* Marks a bus without further device in the current program -----------------*/
+#define NO_DEVICE				0xFF
+
+/* Number of calls per measurement in benchmark_pin_access() ------------------*/
+#define PIN_BENCH_CALLS			100
+
+/* Alarm poll mode reads and re-centres all devices every ALARM_REFRESH periods */
+#define ALARM_REFRESH			20
+
+/* Limits of TH and TL in degrees C ------------------------------------------*/
+#define ALARM_MIN				-55
+#define ALARM_MAX				125
+
+/*
+ * Pins of all 1wire buses, set by ONEWIRE_BUS_PINS in main.h. All are on
+ * OneWire_DS1820_GPIO_Port, so the interrupt driven reading drives them with
+ * one write and samples them with one read of the port.
+ */
+static const uint16_t bus_pins[] = ONEWIRE_BUS_PINS;
+#define BUS_COUNT				(sizeof(bus_pins) / sizeof(bus_pins[0]))
+
+#ifdef ONEWIRE_UART
+_Static_assert(BUS_COUNT == 1, "UART transport drives a single bus only");
+#endif
+
+/* Steps of a transaction, processed one after another by the timer interrupt -*/
+enum Step
+{
+	STEP_RESET,					// reset pulse and sampling of presence pulse
+	STEP_WRITE,					// write the byte given as argument
+	STEP_SELECT,				// MATCH ROM with address of current device, SKIP ROM if only one
+	STEP_READ,					// read as many bytes as given by argument, 0 for read_length()
+	STEP_RELEASE,				// reset pulse to end a truncated read, skipped after full read
+	STEP_WAIT_CONVERSION,		// wait conversion time of the resolution, then read slots till 1
+	STEP_NEXT_DEVICE,			// store result, jump back to step given as argument for next device
+	STEP_ALARM_SEARCH,			// one pass of ALARM SEARCH, jump back to argument for next pass
+	STEP_SKIP_IF_NO_DEVICE,		// jump to step given as argument if no device has to be addressed
+	STEP_WRITE_ALARM,			// WRITE SCRATCHPAD with TH/TL centred around the current device's value
+	STEP_NEXT_ALARM,			// jump back to step given as argument for next device to re-centre
+	STEP_END					// transaction finished
+};
+
+/* Entry of the device table, one per DS1820 found by search_devices() -------*/
+struct Device
+{
+	uint8_t rom[8];				// family code, 48 bit serial number, crc
+	int16_t temperature;		// last valid temperature in degrees C * 10
+	uint8_t valid;				// TRUE if temperature was read at least once
+	uint8_t resolution;			// DS18B20/DS1822 resolution in bits, 0 for DS18S20
+	uint8_t bus;				// index of the bus in ONEWIRE_BUS_PINS the device is connected to
+	uint8_t alarm;				// TRUE if found by ALARM SEARCH, has to be read in alarm poll mode
+	uint16_t crc_errors;		// scratchpad reads with wrong CRC
+	uint16_t retries;			// scratchpad re-reads caused by CRC errors
+};
+
+/* State of the interrupt driven reading -------------------------------------*/
+enum Engine_state
+{
+	ENGINE_IDLE,				// no reading in progress
+	ENGINE_BUSY,				// timer interrupt is processing the program
+	ENGINE_DONE,				// reading finished, waiting for complete_temperature()
+	ENGINE_FAILED				// no presence pulse, waiting for complete_temperature()
+};
+
+/*
+ * Program for a full temperature reading, pairs of step and argument.
+ * Same protocol as the blocking get_temperature(), but all devices of the table
+ * convert at once (SKIP ROM + CONVERT T) and their scratchpads are read one
+ * after another. A sweep costs one conversion time plus one read per device.
+ */
+static const uint8_t reading_program[][2] = {
+	{STEP_RESET, 0},
+	{STEP_WRITE, SKIP_ROM},
+	{STEP_WRITE, CONVERT_T},
+	{STEP_WAIT_CONVERSION, 0},
+	{STEP_RESET, 0},							// step 4, start of loop over devices
+	{STEP_SELECT, 0},
+	{STEP_WRITE, READ_SCRATCHPAD},
+	{STEP_READ, 0},
+	{STEP_NEXT_DEVICE, 4},						// re-reads on CRC error by jumping to step 4
+	{STEP_RELEASE, 0},
+	{STEP_END, 0}
+};
+
+/*
+ * Programs for the pipelined reading. First call only starts a conversion,
+ * every further call reads the result of the previous conversion and starts the
+ * next one. Waiting for the conversion costs a single read slot, if the
+ * conversion finished during the measurement period as expected.
+ */
+static const uint8_t convert_program[][2] = {
+	{STEP_RESET, 0},
+	{STEP_WRITE, SKIP_ROM},
+	{STEP_WRITE, CONVERT_T},
+	{STEP_END, 0}
+};
+static const uint8_t read_and_convert_program[][2] = {
+	{STEP_WAIT_CONVERSION, 0},
+	{STEP_RESET, 0},							// step 1, start of loop over devices
+	{STEP_SELECT, 0},
+	{STEP_WRITE, READ_SCRATCHPAD},
+	{STEP_READ, 0},
+	{STEP_NEXT_DEVICE, 1},
+	{STEP_RESET, 0},
+	{STEP_WRITE, SKIP_ROM},
+	{STEP_WRITE, CONVERT_T},
+	{STEP_END, 0}
+};
+
+#ifdef ONEWIRE_ALARM_WINDOW
+/*
+ * Program for the pipelined reading in alarm poll mode. Instead of reading every
+ * device, ALARM SEARCH finds the devices whose conversion left their TH/TL window.
+ * Only those are read and get a new window around their new value. With no
+ * alarm, a period costs one short search pass instead of a read per device.
+ */
+static const uint8_t alarm_program[][2] = {
+	{STEP_WAIT_CONVERSION, 0},
+	{STEP_RESET, 0},							// step 1, one search pass per alarming device
+	{STEP_WRITE, ALARM_SEARCH},
+	{STEP_ALARM_SEARCH, 1},
+	{STEP_SKIP_IF_NO_DEVICE, 15},
+	{STEP_RESET, 0},							// step 5, read alarming devices
+	{STEP_SELECT, 0},
+	{STEP_WRITE, READ_SCRATCHPAD},
+	{STEP_READ, 0},
+	{STEP_NEXT_DEVICE, 5},
+	{STEP_SKIP_IF_NO_DEVICE, 15},
+	{STEP_RESET, 0},							// step 11, re-centre their windows
+	{STEP_SELECT, 0},
+	{STEP_WRITE_ALARM, 0},
+	{STEP_NEXT_ALARM, 11},
+	{STEP_RESET, 0},							// step 15
+	{STEP_WRITE, SKIP_ROM},
+	{STEP_WRITE, CONVERT_T},
+	{STEP_END, 0}
+};
+#endif
+
+/*
+ * Device table filled by search_devices(). If it's empty, a single device on
+ * the first bus is addressed by SKIP ROM and its result is stored in the first entry.
+ */
+struct Device devices[ONEWIRE_MAX_DEVICES];
+uint8_t device_count = 0;
+uint8_t bus_device_count[BUS_COUNT];						// devices found on each bus
+uint8_t match_rom = FALSE;									// TRUE if any bus holds more than one device
+uint16_t onewire_pin = OneWire_DS1820_Pin;					// bus used by the blocking functions
+
+/*
+ * State of the interrupt driven reading. Shared between main loop and timer interrupt.
+ */
+TIM_HandleTypeDef* onewire_htim;							// timer with 1 MHz clocking the engine
+volatile uint8_t engine_state = ENGINE_IDLE;				// one of enum Engine_state
+const uint8_t (*engine_program)[2] = reading_program;		// currently processed program
+uint8_t engine_step = 0;									// index of current step in program
+uint8_t engine_phase = 0;									// progress within current step
+uint8_t engine_device[BUS_COUNT];							// device table index of current device per bus
+uint8_t engine_retry[BUS_COUNT];							// re-reads of current device per bus
+uint16_t engine_present = 0;								// bit per bus, cleared if bus missed a presence pulse
+uint16_t engine_pins = 0;									// pins of the buses taking part in current step
+uint8_t engine_tx[BUS_COUNT][9];							// bytes sent by STEP_WRITE and STEP_SELECT per bus
+uint8_t engine_tx_len = 0;									// number of bytes in engine_tx, same for all buses
+uint8_t engine_scratchpad[BUS_COUNT][9];					// bytes received by STEP_READ per bus
+uint8_t engine_read_len = 9;								// bytes to receive in current STEP_READ
+int32_t engine_bus_saved = 0;								// bus time in us saved by truncated reads
+int32_t bus_time_saved = 0;									// engine_bus_saved of last finished program
+uint8_t engine_has_result = FALSE;							// TRUE if first device was read
+int16_t engine_temperature = 0;								// result of the last reading
+uint8_t conversion_pending = FALSE;							// TRUE if pipelined conversion was started
+uint32_t conversion_tick = 0;								// HAL tick when last CONVERT_T was sent
+uint16_t conversion_pins = 0;								// pins of the buses the last CONVERT_T was sent on
+uint16_t engine_converted = 0;								// pins of the buses that read 1 while waiting for the conversion
+uint16_t engine_conversion_time = CONVERSION_TIME_MAX;		// longest conversion time of all devices in ms
+uint32_t sample_tick = 0;									// HAL tick when conversion of result started
+uint8_t sample_available = FALSE;							// TRUE after the first successful reading
+volatile uint16_t buses_present = 0;						// bit per bus, set if it answered its last reset pulse
+volatile uint8_t rescan_pending = FALSE;					// a bus answered again after it was missing
+void (*engine_callback)(int16_t temperature, uint8_t valid);	// called when reading ended
+uint8_t engine_alarm_only = FALSE;							// TRUE if only devices with alarm are addressed
+uint8_t engine_searching = FALSE;							// TRUE while ALARM SEARCH passes are running
+uint8_t engine_resets = 0;									// transactions (reset pulses) of the current program
+#ifdef ONEWIRE_ALARM_WINDOW
+uint8_t search_rom[BUS_COUNT][8];							// ROM code of current search pass per bus
+int8_t search_last[BUS_COUNT];								// discrepancy of last pass, -1 if it was the last
+int8_t search_discrepancy[BUS_COUNT];						// discrepancy of current pass
+uint8_t search_index = 0;									// bit of the ROM code processed by current pass
+uint16_t search_buses = 0;									// bit per bus that needs another pass
+uint16_t search_idle = 0;									// bit per bus without alarming device in this pass
+uint16_t search_bits = 0;									// pins that read 1 in the first read slot of a bit
+uint16_t search_complements = 0;							// pins that read 1 in the second read slot of a bit
+uint8_t alarm_refresh = 0;									// periods till all devices are read again
+int32_t transactions_saved = 0;								// transactions saved against reading all devices
+#endif
+#ifdef BENCHMARK_ENABLED
+uint32_t engine_isr_cycles = 0;								// cycles spent in timer interrupt
+#endif
 
 /* Private prototypes --------------------------------------------------------*/
 void set_pin_low_then_high(uint16_t low_time, uint16_t high_time);
 void send_bit(uint8_t bit);
 void send_byte(uint8_t byte);
+uint16_t read_slot_pins(uint16_t pins);
+uint8_t read_slot();
 uint8_t receive_bit();
 uint8_t receive_byte();
-void wait_for_pullup(uint16_t time);
+uint8_t wait_for_pullup(uint16_t time, uint16_t timeout);
 void reset_bus();
 void receive_scratchpad(uint8_t* scratchpad);
 int16_t calculate_temp(uint8_t* scratchpad);
+int16_t calculate_temp_basic(uint8_t* scratchpad);
+int16_t calculate_temp_ds18b20(uint8_t* scratchpad, uint8_t resolution);
+uint8_t is_ds18b20(struct Device* device);
+int16_t convert_scratchpad(struct Device* device, uint8_t* scratchpad);
+uint8_t read_length(struct Device* device);
+uint16_t conversion_time();
+uint8_t select_device(uint8_t index);
+void arm_timer(uint16_t time);
+void next_step();
+uint8_t first_device(uint8_t bus, uint8_t from);
+void restart_devices();
+void update_engine_pins();
+void drop_buses(uint16_t pins);
+uint16_t probe_pins();
+void update_presence(uint16_t pins, uint16_t answered);
+void clear_scratchpad();
+uint8_t check_scratchpad(uint8_t bus);
+void load_tx(uint8_t step, uint8_t arg);
+uint8_t engine_read_length();
+void finish_reading(uint8_t state);
+uint16_t next_device(uint8_t arg);
+uint16_t skip_if_no_device(uint8_t arg);
+void alarm_window(struct Device* device, uint8_t* th, uint8_t* tl);
+#ifdef ONEWIRE_ALARM_WINDOW
+void alarm_start();
+uint8_t search_direction(uint8_t bus, uint8_t i, uint8_t bit, uint8_t complement);
+void alarm_pass_end(uint8_t arg);
+void alarm_search_end();
+uint16_t next_alarm(uint8_t arg);
+#endif
+uint16_t conversion_wait();
+uint16_t conversion_polled(uint16_t converted);
+uint16_t process_step();
+void run_engine();
+uint8_t start_program(const uint8_t (*program)[2], void (*callback)(int16_t temperature, uint8_t valid));
 
 /**
   * @brief Sets OneWire_Pin to low -> delays -> sets pin to high -> delays
@@ -44,9 +311,9 @@ int16_t calculate_temp(uint8_t* scratchpad);
   * @retval None
   */
 void set_pin_low_then_high(uint16_t low_time, uint16_t high_time) {
-	HAL_GPIO_WritePin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin, GPIO_PIN_RESET);
+	gpio_reset(OneWire_DS1820_GPIO_Port, onewire_pin);
 	delayUs(low_time);
-	HAL_GPIO_WritePin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin, GPIO_PIN_SET);
+	gpio_set(OneWire_DS1820_GPIO_Port, onewire_pin);
 	delayUs(high_time);
 }
 
@@ -57,7 +324,11 @@ void set_pin_low_then_high(uint16_t low_time, uint16_t high_time) {
   * @retval None
   */
 void send_bit(uint8_t bit) {
+#ifdef ONEWIRE_UART
+	onewire_uart_bit(bit);
+#else
 	bit == 0 ? set_pin_low_then_high(SEND_LONG, SEND_SHORT) : set_pin_low_then_high(SEND_SHORT, SEND_LONG);
+#endif
 }
 
 /**
@@ -72,6 +343,30 @@ void send_byte(uint8_t byte) {
 	}
 }
 
+/**
+  * @brief Creates a master read slot on several buses at once by pulling them to
+  * 	   low and samples them with one read of the port 10 us later. The rest of
+  * 	   the slot is left to the caller.
+  * @param uint16_t pins pins of the buses
+  * @retval uint16_t pins of the buses that read 1
+  */
+uint16_t read_slot_pins(uint16_t pins) {
+	gpio_reset(OneWire_DS1820_GPIO_Port, pins);
+	delayUs(READ_LOW);
+	gpio_set(OneWire_DS1820_GPIO_Port, pins);
+	delayUs(READ_WAIT);
+	return gpio_read(OneWire_DS1820_GPIO_Port, pins);
+}
+
+/**
+  * @brief Creates a master read slot by pulling the channel to low and samples
+  * 	   the channel 10 us later. The rest of the slot is left to the caller.
+  * @retval uint8_t bit bit read from the 1wire channel.
+  */
+uint8_t read_slot() {
+	return (read_slot_pins(onewire_pin) ? 1 : 0);
+}
+
 /**
   * @brief Function used to receive one single bit from the 1wire channel.
   * 	   Creates a master read slot by pulling the channel to low. Afterwards
@@ -80,11 +375,13 @@ void send_byte(uint8_t byte) {
   * @retval uint8_t bit bit read from the 1wire channel.
   */
 uint8_t receive_bit() {
-	uint8_t bit = 0;
-	set_pin_low_then_high(READ_LOW, READ_WAIT);						// Create a read slot and wait 10 us
-	bit = (HAL_GPIO_ReadPin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin) ? 1 : 0);
+#ifdef ONEWIRE_UART
+	return onewire_uart_bit(1);
+#else
+	uint8_t bit = read_slot();
 	delayUs(40);
 	return bit;
+#endif
 }
 
 /**
@@ -102,14 +399,21 @@ uint8_t receive_byte() {
 
 /**
   * @brief Function used to let the master wait till temperature conversion is done on DS1820.
-  *        DS1820 pulls 1wire to low after receiving Convert T (44h) command, releases the channel and
-  *        the channel gets pulled to high by pull up, after conversion is done.
+  *        DS1820 answers read slots with 0 after receiving Convert T (44h) command, the channel
+  *        gets pulled to high by pull up in read slots, after conversion is done.
+  *        Gives up after timeout, so an unplugged or shorted probe can't hang the firmware.
   * @param uint16_t time amount of time to wait before sampling.
-  * @retval None
+  * @param uint16_t timeout amount of time in ms after which the conversion is given up
+  * @retval uint8_t TRUE if conversion is done, FALSE on timeout
   */
-void wait_for_pullup(uint16_t time) {
+uint8_t wait_for_pullup(uint16_t time, uint16_t timeout) {
+	uint32_t start = HAL_GetTick();
+
 	delayUs(time);
-	while (HAL_GPIO_ReadPin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin) == GPIO_PIN_RESET);
+	while (!receive_bit()) {
+		if (HAL_GetTick() - start > timeout) return FALSE;
+	}
+	return TRUE;
 }
 
 /**
@@ -119,7 +423,11 @@ void wait_for_pullup(uint16_t time) {
   * @retval None
   */
 void reset_bus() {
+#ifdef ONEWIRE_UART
+	onewire_uart_reset();
+#else
 	set_pin_low_then_high(RESET, RESET);
+#endif
 }
 
 
@@ -137,15 +445,18 @@ void reset_bus() {
   * 	  	 	- READ SCRATCHPAD (BEh) by function receive_scratchpad
   *
   * 	  With the full scratchpad read, temperature calculation is done by
-  * 	  calculate_temp.
-  * @retval int16_t Returns the value returned by temperature calculation.
+  * 	  calculate_temp. Fails fast after the first reset pulse (~1 ms) if no
+  * 	  device answers, and after the conversion timeout of the resolution.
+  * @retval int16_t Returns the value returned by temperature calculation,
+  * 		   TEMPERATURE_INVALID if the DS1820 didn't answer.
   */
 int16_t get_temperature() {
 	uint8_t scratchpad[] = {0,0,0,0,0,0,0,0,0};
-	reset_bus();
+	onewire_pin = bus_pins[0];
+	if (!get_presence()) return TEMPERATURE_INVALID;
 	send_byte(SKIP_ROM);
 	send_byte(CONVERT_T);
-	wait_for_pullup(20);
+	if (!wait_for_pullup(20, CONVERSION_TIMEOUT(conversion_time()))) return TEMPERATURE_INVALID;
 	delayUs(20);
 	reset_bus();
 	send_byte(SKIP_ROM);
@@ -189,20 +500,1467 @@ int16_t calculate_temp(uint8_t* scratchpad) {
     return val;
 }
 
+/**
+  * @brief Function used to calculate the temperature with the basic resolution of
+  * 	   0.5 degrees C. Only needs TEMPERATURE LSB and MSB (bytes 0 and 1).
+  * @param uint8_t* scratchpad local scratchpad to use for calculation
+  * @retval int16_t the temperature in degrees C with 1 decimal place * 10
+  */
+int16_t calculate_temp_basic(uint8_t* scratchpad) {
+	int16_t val = (scratchpad[1] << 8) | scratchpad[0];	// temp in 0.5 degs C
+
+	return val * 5;
+}
+
+/**
+  * @brief Function used to calculate the temperature of a DS18B20 or DS1822.
+  * 	   TEMPERATURE LSB and MSB hold the temperature in 1/16 degrees C, bits below
+  * 	   the configured resolution are undefined and cleared.
+  * @param uint8_t* scratchpad local scratchpad to use for calculation
+  * @param uint8_t resolution configured resolution in bits, 9 to 12
+  * @retval int16_t the temperature in degrees C with 1 decimal place * 10
+  */
+int16_t calculate_temp_ds18b20(uint8_t* scratchpad, uint8_t resolution) {
+	int16_t val = (scratchpad[1] << 8) | scratchpad[0];	// temp in 1/16 degs C
+
+	val &= ~((1 << (12 - resolution)) - 1);		// clear undefined bits
+	val *= 10;									// for 1 decimal place
+	val >>= 4;									// divide by 16
+
+	return val;
+}
+
+/**
+  * @brief Checks the family code of a device for the DS18B20 register layout.
+  * 	   Devices without ROM code (empty device table) are treated as DS18S20.
+  * @param struct Device* device entry of the device table
+  * @retval uint8_t TRUE for DS18B20 and DS1822, FALSE otherwise
+  */
+uint8_t is_ds18b20(struct Device* device) {
+	return device->rom[0] == FAMILY_DS18B20 || device->rom[0] == FAMILY_DS1822;
+}
+
+/**
+  * @brief Calculates the temperature with the conversion routine matching the
+  * 	   family code of the device. For DS18S20 the routine is selected by
+  * 	   ONEWIRE_EXTENDED_RESOLUTION in main.h.
+  * @param struct Device* device entry of the device table the scratchpad belongs to
+  * @param uint8_t* scratchpad local scratchpad to use for calculation
+  * @retval int16_t the temperature in degrees C with 1 decimal place * 10
+  */
+int16_t convert_scratchpad(struct Device* device, uint8_t* scratchpad) {
+	if (is_ds18b20(device)) return calculate_temp_ds18b20(scratchpad, device->resolution);
+#ifdef ONEWIRE_EXTENDED_RESOLUTION
+	return calculate_temp(scratchpad);
+#else
+	return calculate_temp_basic(scratchpad);
+#endif
+}
+
+/**
+  * @brief Returns how many scratchpad bytes have to be read, depending on the
+  * 	   conversion routine of the device and CRC verification. The DS1820 sends
+  * 	   the scratchpad from byte 0 on, the rest is cut off by a reset pulse.
+  * 	   		- CRC verification: all 9 bytes, CRC is in byte 8
+  * 	   		- DS18S20 extended resolution: 8 bytes, COUNT_REMAIN and COUNT_PER_C are in 6 and 7
+  * 	   		- DS18S20 basic resolution, DS18B20: 2 bytes, TEMPERATURE LSB and MSB
+  * @param struct Device* device entry of the device table to read
+  * @retval uint8_t number of bytes to read
+  */
+uint8_t read_length(struct Device* device) {
+#if defined(ONEWIRE_CHECK_CRC)
+	return 9;
+#elif defined(ONEWIRE_EXTENDED_RESOLUTION)
+	return is_ds18b20(device) ? 2 : 8;
+#else
+	return 2;
+#endif
+}
+
+/**
+  * @brief Returns the conversion time of a broadcast CONVERT T, which is the
+  * 	   longest conversion time of all devices in the table. DS18S20 always need
+  * 	   750 ms, DS18B20 halve it with every bit of resolution less than 12.
+  * @retval uint16_t conversion time in ms
+  */
+uint16_t conversion_time() {
+	uint16_t time = 0;
+
+	if (device_count == 0) return CONVERSION_TIME_MAX;
+	for (uint8_t i = 0; i < device_count; i++) {
+		uint16_t device_time = CONVERSION_TIME_MAX;
+		if (is_ds18b20(&devices[i])) device_time >>= 12 - devices[i].resolution;
+		if (device_time > time) time = device_time;
+	}
+	return time;
+}
+
 /**
   * @brief Resets the bus by sending 1wire specific reset pulse.
   * 	   DS1820 will answer with presence pulse. Sampling for
   * 	   presence pulse and returning value if or if not presence
-  * 	   pulse was received.
+  * 	   pulse was received. A bus that is low before the reset pulse
+  * 	   is shorted and reported as not present without a reset pulse.
   * @retval uint8_t FALSE if not present, TRUE otherwise
   */
 uint8_t get_presence() {
+#ifdef ONEWIRE_UART
+	return onewire_uart_reset();
+#else
 	uint8_t present = FALSE;
-	set_pin_low_then_high(RESET, 30);		// Create Reset Pulse and wait 30 us
-	present = (HAL_GPIO_ReadPin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin) ? TRUE : FALSE);
-	delayUs(400);
+	if (!gpio_read(OneWire_DS1820_GPIO_Port, onewire_pin)) return FALSE;	// shorted
+	set_pin_low_then_high(RESET, PRESENCE_WAIT);	// Create Reset Pulse and wait for presence pulse
+	present = (gpio_read(OneWire_DS1820_GPIO_Port, onewire_pin) ? FALSE : TRUE);
+	delayUs(PRESENCE_RECOVER);
 	return present;
+#endif
+}
+
+/**
+  * @brief Enumerates all devices on one bus with SEARCH ROM (F0h) and appends
+  * 	   their addresses to the device table. Each pass walks the binary tree of
+  * 	   ROM codes: every bit is read twice (bit and its complement), then the
+  * 	   master writes the direction to follow. Both read 0 means there are devices
+  * 	   on both branches, the 0 branch is taken first and remembered as discrepancy,
+  * 	   the next pass takes the 1 branch there. Blocking, takes ~13 ms per device.
+  * 	   A pass with a bus error is repeated, devices of completed passes are
+  * 	   kept. If it keeps failing, the search ends and a rescan is requested
+  * 	   from onewire_hotplug_poll().
+  * @param uint8_t bus index of the bus in ONEWIRE_BUS_PINS
+  * @param uint8_t start number of devices already in the table
+  * @retval uint8_t number of devices in the table afterwards
+  */
+uint8_t search_bus(uint8_t bus, uint8_t start) {
+	uint8_t rom[8] = {0,0,0,0,0,0,0,0};
+	int8_t last_discrepancy = -1;
+	uint8_t count = start;
+	uint8_t retries = 0;
+	uint8_t failed;
+
+	onewire_pin = bus_pins[bus];
+	while (count < ONEWIRE_MAX_DEVICES) {				// a pass stores a device, so check before it
+		int8_t discrepancy = -1;
+		failed = FALSE;
+		if (!get_presence()) break;
+		send_byte(SEARCH_ROM);
+		for (int8_t i = 0; i < 64; i++) {
+			uint8_t bit = receive_bit();
+			uint8_t complement = receive_bit();
+			uint8_t direction;
+			if (bit && complement) {					// no device answered, bus error
+				if (++retries > SEARCH_RETRIES) {
+					last_discrepancy = -1;				// give up, found devices are kept
+					rescan_pending = TRUE;
+				} else {
+					failed = TRUE;						// same pass again, last_discrepancy is unchanged
+				}
+				break;
+			}
+			if (bit != complement) direction = bit;		// all devices agree
+			else if (i < last_discrepancy) direction = rom[i >> 3] >> (i & 7) & 1;
+			else direction = (i == last_discrepancy);
+			if (bit == complement && direction == 0) discrepancy = i;
+			rom[i >> 3] = (rom[i >> 3] & ~(1 << (i & 7))) | (direction << (i & 7));
+			send_bit(direction);
+			if (i == 63) {								// full address received
+				last_discrepancy = discrepancy;
+				retries = 0;
+				if (crc8(rom, 8) != 0) continue;		// corrupted address, not stored
+				for (uint8_t j = 0; j < 8; j++) {
+					devices[count].rom[j] = rom[j];
+				}
+				devices[count].valid = FALSE;
+				devices[count].resolution = (is_ds18b20(&devices[count]) ? 12 : 0);	// worst case till read
+				devices[count].bus = bus;
+				devices[count].crc_errors = 0;
+				devices[count].retries = 0;
+				count++;
+			}
+		}
+		if (!failed && last_discrepancy < 0) break;		// no branch left
+	}
+
+	return count;
+}
+
+/**
+  * @brief Enumerates the devices of all buses in ONEWIRE_BUS_PINS and stores
+  * 	   their addresses in the device table, see search_bus(). Buses after
+  * 	   the one that filled the table are skipped and get no devices. Blocking.
+  * 	   Must only be called while no interrupt driven reading is in progress.
+  * @retval uint8_t number of devices found, at most ONEWIRE_MAX_DEVICES
+  */
+uint8_t search_devices() {
+	uint8_t count = 0;
+	uint16_t present = 0;
+
+	if (engine_state != ENGINE_IDLE) return device_count;
+
+	match_rom = FALSE;
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		uint8_t start = count;
+		bus_device_count[bus] = 0;
+		if (count >= ONEWIRE_MAX_DEVICES) continue;		// table full
+		count = search_bus(bus, count);
+		bus_device_count[bus] = count - start;
+		if (bus_device_count[bus] > 1) match_rom = TRUE;
+		if (count > start || get_presence()) present |= 1 << bus;
+	}
+	onewire_pin = bus_pins[0];
+
+	device_count = count;
+	buses_present = present;
+	return count;
+}
+
+/**
+  * @brief Addresses a device for the next command: reset pulse on its bus, then MATCH ROM
+  * 	   with its ROM code, or SKIP ROM if it's the only device on its bus. Blocking.
+  * @param uint8_t index index in device table
+  * @retval uint8_t TRUE if a presence pulse was received, FALSE otherwise
+  */
+uint8_t select_device(uint8_t index) {
+	onewire_pin = bus_pins[devices[index].bus];
+	if (!get_presence()) return FALSE;
+	if (bus_device_count[devices[index].bus] > 1) {
+		send_byte(MATCH_ROM);
+		for (uint8_t i = 0; i < 8; i++) {
+			send_byte(devices[index].rom[i]);
+		}
+	} else {
+		send_byte(SKIP_ROM);
+	}
+	return TRUE;
+}
+
+/**
+  * @brief Reads the full scratchpad of a device and checks its CRC. Blocking.
+  * @param uint8_t index index in device table
+  * @param uint8_t* scratchpad 9 bytes to fill
+  * @retval uint8_t TRUE if the scratchpad was read correctly, FALSE otherwise
+  */
+uint8_t read_device_scratchpad(uint8_t index, uint8_t* scratchpad) {
+	if (!select_device(index)) return FALSE;
+	send_byte(READ_SCRATCHPAD);
+	receive_scratchpad(scratchpad);
+	return crc8(scratchpad, 9) == 0;
+}
+
+/**
+  * @brief Writes TH, TL and for DS18B20 the configuration register of a device
+  * 	   and copies them to its EEPROM, so they survive a power cycle. Blocking,
+  * 	   takes ~15 ms because of the EEPROM write.
+  * @param uint8_t index index in device table
+  * @param uint8_t th TH register or user byte 1
+  * @param uint8_t tl TL register or user byte 2
+  * @param uint8_t config configuration register, ignored for DS18S20
+  * @retval uint8_t TRUE if device answered, FALSE otherwise
+  */
+uint8_t write_device_scratchpad(uint8_t index, uint8_t th, uint8_t tl, uint8_t config) {
+	if (!select_device(index)) return FALSE;
+	send_byte(WRITE_SCRATCHPAD);
+	send_byte(th);
+	send_byte(tl);
+	if (is_ds18b20(&devices[index])) send_byte(config);
+	if (!select_device(index)) return FALSE;
+	send_byte(COPY_SCRATCHPAD);
+	HAL_Delay(COPY_TIME);
+	return TRUE;
+}
+
+/**
+  * @brief Sets the resolution of all DS18B20 and DS1822 in the device table.
+  * 	   Shorter resolutions shorten the conversion: 9 bit 94 ms, 10 bit 188 ms,
+  * 	   11 bit 375 ms, 12 bit 750 ms. TH and TL are kept. The EEPROM is only
+  * 	   written if the configuration differs. Blocking, must only be called while
+  * 	   no interrupt driven reading is in progress.
+  * @param uint8_t bits resolution in bits, 9 to 12
+  * @retval uint8_t number of devices configured
+  */
+uint8_t set_resolution(uint8_t bits) {
+	uint8_t scratchpad[9];
+	uint8_t config = ((bits - 9) << 5) | 0x1F;		// R1 R0 in bits 6 and 5, rest reads as 1
+	uint8_t count = 0;
+
+	if (engine_state != ENGINE_IDLE || bits < 9 || bits > 12) return 0;
+
+	for (uint8_t i = 0; i < device_count; i++) {
+		if (!is_ds18b20(&devices[i])) continue;
+		if (!read_device_scratchpad(i, scratchpad)) continue;
+		if (scratchpad[4] != config) {
+			if (!write_device_scratchpad(i, scratchpad[2], scratchpad[3], config)) continue;
+		}
+		devices[i].resolution = bits;
+		count++;
+	}
+	return count;
+}
+
+/**
+  * @brief Sets the TH and TL alarm thresholds of a device, the configuration is
+  * 	   kept. A device is found by ALARM SEARCH if the integer part of its last
+  * 	   conversion is >= TH or <= TL. Stored in the EEPROM. Blocking, must only be
+  * 	   called while no interrupt driven reading is in progress.
+  * @param uint8_t index index in device table
+  * @param int8_t th upper threshold in degrees C
+  * @param int8_t tl lower threshold in degrees C
+  * @retval uint8_t TRUE if the thresholds were written, FALSE otherwise
+  */
+uint8_t set_alarm(uint8_t index, int8_t th, int8_t tl) {
+	uint8_t scratchpad[9];
+
+	if (engine_state != ENGINE_IDLE || index >= device_count) return FALSE;
+	if (!read_device_scratchpad(index, scratchpad)) return FALSE;
+	return write_device_scratchpad(index, th, tl, scratchpad[4]);
+}
+
+/**
+  * @brief Returns the number of devices in the device table.
+  * @retval uint8_t number of devices found by search_devices()
+  */
+uint8_t get_device_count() {
+	return device_count;
+}
+
+/**
+  * @brief Returns the last valid temperature of a device from the device table.
+  * @param uint8_t index index in device table
+  * @param int16_t* temperature is set to the temperature in degrees C * 10
+  * @retval uint8_t TRUE if temperature was set, FALSE if device has no valid reading
+  * 		   or its bus didn't answer the last reset pulse
+  */
+uint8_t get_device_temperature(uint8_t index, int16_t* temperature) {
+	if (index >= ONEWIRE_MAX_DEVICES || !devices[index].valid || !is_device_present(index)) return FALSE;
+	*temperature = devices[index].temperature;
+	return TRUE;
+}
+
+/**
+  * @brief Returns the CRC statistics of a device from the device table.
+  * @param uint8_t index index in device table
+  * @param uint16_t* crc_errors is set to the number of scratchpad reads with wrong CRC
+  * @param uint16_t* retries is set to the number of re-reads caused by them
+  * @retval None
+  */
+void get_device_errors(uint8_t index, uint16_t* crc_errors, uint16_t* retries) {
+	if (index >= ONEWIRE_MAX_DEVICES) return;
+	*crc_errors = devices[index].crc_errors;
+	*retries = devices[index].retries;
+}
+
+/**
+  * @brief Stores the timer used by the interrupt driven reading. The timer has to
+  * 	   be initialized with a 1 MHz counter clock and without auto reload preload,
+  * 	   its period elapsed callback has to call onewire_timer_tick().
+  * 	   Configures the pins of additional buses in ONEWIRE_BUS_PINS like
+  * 	   OneWire_DS1820_Pin and releases all buses.
+  * @param TIM_HandleTypeDef* htim timer handle
+  * @retval None
+  */
+void onewire_init(TIM_HandleTypeDef* htim) {
+	onewire_htim = htim;
+#ifndef ONEWIRE_UART
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		GPIO_InitStruct.Pin |= bus_pins[bus];
+	}
+	HAL_GPIO_WritePin(OneWire_DS1820_GPIO_Port, GPIO_InitStruct.Pin, GPIO_PIN_SET);
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+	HAL_GPIO_Init(OneWire_DS1820_GPIO_Port, &GPIO_InitStruct);
+#endif
+}
+
+/**
+  * @brief Lets the timer elapse again after given time, measured from now.
+  * @param uint16_t time time in us till next timer interrupt, at least 2
+  * @retval None
+  */
+void arm_timer(uint16_t time) {
+	__HAL_TIM_SET_AUTORELOAD(onewire_htim, time - 1);
+	__HAL_TIM_SET_COUNTER(onewire_htim, 0);
+	__HAL_TIM_ENABLE(onewire_htim);						// stopped while a UART transfer was running
 }
 
+/**
+  * @brief Advances the engine to the next step of the program.
+  * @retval None
+  */
+void next_step() {
+	engine_step++;
+	engine_phase = 0;
+}
 
+/**
+  * @brief Returns the first device of the device table on a bus, starting at given index.
+  * 	   With an empty table, the first bus has a single device addressed by SKIP ROM.
+  * 	   While engine_alarm_only is set, devices without alarm are skipped.
+  * @param uint8_t bus index of the bus in ONEWIRE_BUS_PINS
+  * @param uint8_t from device table index to start at
+  * @retval uint8_t device table index, NO_DEVICE if there is none
+  */
+uint8_t first_device(uint8_t bus, uint8_t from) {
+	if (device_count == 0) return (bus == 0 && from == 0 ? 0 : NO_DEVICE);
+	for (uint8_t i = from; i < device_count; i++) {
+		if (devices[i].bus == bus && (!engine_alarm_only || devices[i].alarm)) return i;
+	}
+	return NO_DEVICE;
+}
+
+/**
+  * @brief Lets every bus start over with its first device.
+  * @retval None
+  */
+void restart_devices() {
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		engine_device[bus] = first_device(bus, 0);
+	}
+	update_engine_pins();
+}
+
+/**
+  * @brief Collects the pins of all buses, which still have a device to read (or
+  * 	   another ALARM SEARCH pass to do) and answered every reset pulse of the current program.
+  * @retval None
+  */
+void update_engine_pins() {
+	engine_pins = 0;
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		uint8_t active = (engine_device[bus] != NO_DEVICE);
+#ifdef ONEWIRE_ALARM_WINDOW
+		if (engine_searching) active = (search_buses >> bus & 1);
+#endif
+		if (active && (engine_present >> bus & 1)) engine_pins |= bus_pins[bus];
+	}
+}
+
+/**
+  * @brief Excludes buses from the rest of the current program, e.g. if they missed
+  * 	   the presence pulse. The other buses go on.
+  * @param uint16_t pins pins of the buses to exclude
+  * @retval None
+  */
+void drop_buses(uint16_t pins) {
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		if (bus_pins[bus] & pins) engine_present &= ~(1 << bus);
+	}
+	update_engine_pins();
+}
+
+/**
+  * @brief Collects the pins of the buses without device in the table. They get the
+  * 	   first reset pulse of a program too, so a sensor plugged into them is
+  * 	   noticed. Not done with a full table, the sensor couldn't be added anyway.
+  * @retval uint16_t pins of the buses to probe
+  */
+uint16_t probe_pins() {
+	uint16_t pins = 0;
+
+	if (device_count >= ONEWIRE_MAX_DEVICES) return 0;
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		if (bus_device_count[bus] == 0 && (device_count > 0 || bus > 0)) pins |= bus_pins[bus];
+	}
+	return pins;
+}
+
+/**
+  * @brief Stores which buses answered a reset pulse. A bus that answers again
+  * 	   after it was missing requests a rescan by onewire_hotplug_poll().
+  * @param uint16_t pins pins of the buses the reset pulse was sent on
+  * @param uint16_t answered pins of the buses that sent a presence pulse
+  * @retval None
+  */
+void update_presence(uint16_t pins, uint16_t answered) {
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		if (!(bus_pins[bus] & pins)) continue;
+		if (bus_pins[bus] & answered) {
+			if (!(buses_present >> bus & 1)) rescan_pending = TRUE;	// sensor plugged in again
+			buses_present |= 1 << bus;
+		} else {
+			buses_present &= ~(1 << bus);
+		}
+	}
+}
+
+/**
+  * @brief Clears the scratchpads before the next devices are read.
+  * @retval None
+  */
+void clear_scratchpad() {
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		for (uint8_t i = 0; i < 9; i++) {
+			engine_scratchpad[bus][i] = 0;
+		}
+	}
+}
+
+/**
+  * @brief Checks the received scratchpad against its CRC in byte 8, if it was read.
+  * 	   An all zero scratchpad has a valid CRC too, but is caused by a bus stuck low.
+  * 	   All ones is read if the addressed device is missing.
+  * @param uint8_t bus index of the bus the scratchpad was read from
+  * @retval uint8_t TRUE if scratchpad is intact, FALSE otherwise
+  */
+uint8_t check_scratchpad(uint8_t bus) {
+	uint8_t* scratchpad = engine_scratchpad[bus];
+	uint8_t any_set = 0;
+	uint8_t all_set = 0xFF;
+	for (uint8_t i = 0; i < engine_read_len; i++) {
+		any_set |= scratchpad[i];
+		all_set &= scratchpad[i];
+	}
+	if (!any_set || all_set == 0xFF) return FALSE;
+	if (engine_read_len < 9) return TRUE;
+	return crc8(scratchpad, 9) == 0;
+}
+
+/**
+  * @brief Fills the transmit buffers of all buses for STEP_WRITE, STEP_SELECT or
+  * 	   STEP_WRITE_ALARM. STEP_SELECT addresses the current device of each bus by
+  * 	   MATCH ROM, or sends SKIP ROM if no bus holds more than one device.
+  * 	   All buses send the same number of bytes, so they stay in lockstep.
+  * @param uint8_t step STEP_WRITE, STEP_SELECT or STEP_WRITE_ALARM
+  * @param uint8_t arg argument of the step
+  * @retval None
+  */
+void load_tx(uint8_t step, uint8_t arg) {
+	engine_tx_len = (step == STEP_SELECT && match_rom ? 9 : 1);
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		uint8_t* tx = engine_tx[bus];
+		struct Device* device;
+		if (!(engine_pins & bus_pins[bus])) continue;
+		device = &devices[engine_device[bus]];
+		if (step == STEP_SELECT && match_rom) {
+			tx[0] = MATCH_ROM;
+			for (uint8_t i = 0; i < 8; i++) {
+				tx[i + 1] = device->rom[i];
+			}
+		} else if (step == STEP_WRITE_ALARM) {
+			tx[0] = WRITE_SCRATCHPAD;
+			alarm_window(device, &tx[1], &tx[2]);
+			tx[3] = ((device->resolution - 9) << 5) | 0x1F;
+			if (engine_tx_len < 3) engine_tx_len = 3;
+			if (is_ds18b20(device)) engine_tx_len = 4;	// configuration register, ignored by DS18S20
+		} else {
+			tx[0] = (step == STEP_SELECT ? SKIP_ROM : arg);
+		}
+	}
+}
 
+/**
+  * @brief Returns the number of scratchpad bytes to read, the most any current
+  * 	   device needs, see read_length().
+  * @retval uint8_t number of bytes to read
+  */
+uint8_t engine_read_length() {
+	uint8_t length = 0;
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		if (!(engine_pins & bus_pins[bus])) continue;
+		uint8_t bus_length = read_length(&devices[engine_device[bus]]);
+		if (bus_length > length) length = bus_length;
+	}
+	return length;
+}
+
+/**
+  * @brief Ends the current reading, stops the timer and calls the callback.
+  * 	   Called in interrupt context.
+  * @param uint8_t state ENGINE_DONE or ENGINE_FAILED
+  * @retval None
+  */
+void finish_reading(uint8_t state) {
+	uint8_t valid = (state == ENGINE_DONE && engine_has_result);
+
+	HAL_TIM_Base_Stop_IT(onewire_htim);
+	if (valid) {
+		engine_temperature = devices[0].temperature;
+		sample_available = TRUE;
+	}
+	conversion_pending = (state == ENGINE_DONE && engine_program != reading_program);
+	bus_time_saved = engine_bus_saved;
+#ifdef ONEWIRE_ALARM_WINDOW
+	if (state == ENGINE_DONE && engine_program == alarm_program) {
+		transactions_saved += (device_count + 1) - engine_resets;	// reading all is a read per device + CONVERT T
+	}
+#endif
+	engine_state = state;
+	if (engine_callback) (*engine_callback)(engine_temperature, valid);
+}
+
+/**
+  * @brief Stores the results of the current devices and moves every bus on to
+  * 	   its next device. Re-reads a scratchpad on CRC errors, the conversion
+  * 	   result is kept. When all buses are done, they are all addressed again by
+  * 	   the following steps.
+  * @param uint8_t arg step to jump back to for the next devices
+  * @retval uint16_t time in us till the next step, 0 to process it immediately
+  */
+uint16_t next_device(uint8_t arg) {
+	uint8_t retry = 0;
+	uint8_t more = FALSE;
+
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		uint8_t index = engine_device[bus];
+		struct Device* device;
+		if (!(engine_pins & bus_pins[bus])) continue;
+		device = &devices[index];
+		if (check_scratchpad(bus)) {
+			uint8_t* scratchpad = engine_scratchpad[bus];
+			if (is_ds18b20(device) && engine_read_len > 4) {	// configuration register was read
+				device->resolution = 9 + (scratchpad[4] >> 5 & 3);
+			}
+			device->temperature = convert_scratchpad(device, scratchpad);
+			device->valid = TRUE;
+			if (index == 0) {
+				engine_has_result = TRUE;
+				sample_tick = conversion_tick;			// scratchpad holds result of last CONVERT_T
+			}
+		} else {
+			device->crc_errors++;
+			if (engine_retry[bus] < MAX_RETRIES) {		// read scratchpad again, conversion result is kept
+				engine_retry[bus]++;
+				device->retries++;
+				if (engine_retry[bus] > retry) retry = engine_retry[bus];
+				more = TRUE;
+				continue;
+			}
+			device->alarm = FALSE;						// no valid value to centre its window around
+		}
+		engine_retry[bus] = 0;
+		engine_device[bus] = first_device(bus, index + 1);
+		if (engine_device[bus] != NO_DEVICE) more = TRUE;
+	}
+	clear_scratchpad();
+
+	if (more) {											// loop for next devices
+		update_engine_pins();
+		engine_step = arg;
+		engine_phase = 0;
+		return RETRY_BACKOFF * retry;
+	}
+	restart_devices();
+	next_step();
+	return 0;
+}
+
+/**
+  * @brief Skips the following steps, if no device has to be addressed by them.
+  * 	   Then all devices are addressed again from the target step on.
+  * @param uint8_t arg step to jump to
+  * @retval uint16_t 0, next step can be processed immediately
+  */
+uint16_t skip_if_no_device(uint8_t arg) {
+	if (engine_pins) {
+		next_step();
+		return 0;
+	}
+	engine_alarm_only = FALSE;
+	restart_devices();
+	engine_step = arg;
+	engine_phase = 0;
+	return 0;
+}
+
+/**
+  * @brief Calculates a TH/TL window of ONEWIRE_ALARM_WINDOW degrees C around
+  * 	   the last value of a device. The DS1820 compares the integer part of the
+  * 	   temperature, alarm is set if it's >= TH or <= TL.
+  * @param struct Device* device entry of the device table
+  * @param uint8_t* th is set to the TH register
+  * @param uint8_t* tl is set to the TL register
+  * @retval None
+  */
+void alarm_window(struct Device* device, uint8_t* th, uint8_t* tl) {
+#ifdef ONEWIRE_ALARM_WINDOW
+	int16_t centre = device->temperature;
+	int16_t high;
+	int16_t low;
+
+	centre = (centre >= 0 ? centre / 10 : -((-centre + 9) / 10));	// integer part, rounded down
+	high = centre + ONEWIRE_ALARM_WINDOW;
+	low = centre - ONEWIRE_ALARM_WINDOW;
+	if (high > ALARM_MAX) high = ALARM_MAX;
+	if (low < ALARM_MIN) low = ALARM_MIN;
+	*th = (int8_t) high;
+	*tl = (int8_t) low;
+#else
+	*th = ALARM_MAX;
+	*tl = (uint8_t) ALARM_MIN;
+#endif
+}
+
+#ifdef ONEWIRE_ALARM_WINDOW
+/**
+  * @brief Prepares the ALARM SEARCH passes of the alarm program. All buses with
+  * 	   devices take part in the first pass.
+  * @retval None
+  */
+void alarm_start() {
+	engine_searching = TRUE;
+	search_buses = 0;
+	search_index = 0;
+	for (uint8_t i = 0; i < device_count; i++) {
+		devices[i].alarm = FALSE;
+		search_buses |= 1 << devices[i].bus;
+	}
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		search_last[bus] = -1;
+	}
+	update_engine_pins();
+}
+
+/**
+  * @brief Processes one bit of an ALARM SEARCH pass on a bus, like search_bus().
+  * @param uint8_t bus index of the bus
+  * @param uint8_t i bit index in the ROM code
+  * @param uint8_t bit bit read in the first read slot
+  * @param uint8_t complement bit read in the second read slot
+  * @retval uint8_t direction to write, 2 if no device with alarm answered
+  */
+uint8_t search_direction(uint8_t bus, uint8_t i, uint8_t bit, uint8_t complement) {
+	uint8_t* rom = search_rom[bus];
+	uint8_t direction;
+
+	if (bit && complement) return 2;
+	if (bit != complement) direction = bit;				// all devices agree
+	else if (i < search_last[bus]) direction = rom[i >> 3] >> (i & 7) & 1;
+	else direction = (i == search_last[bus]);
+	if (bit == complement && direction == 0) search_discrepancy[bus] = i;
+	rom[i >> 3] = (rom[i >> 3] & ~(1 << (i & 7))) | (direction << (i & 7));
+	return direction;
+}
+
+/**
+  * @brief Ends an ALARM SEARCH pass. Marks the found devices with alarm, then
+  * 	   jumps back for another pass if a bus has one left.
+  * @param uint8_t arg step to jump back to for the next pass
+  * @retval None
+  */
+void alarm_pass_end(uint8_t arg) {
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		if (!(engine_pins & bus_pins[bus])) continue;
+		if (search_idle >> bus & 1) {					// no (further) device with alarm
+			search_buses &= ~(1 << bus);
+			continue;
+		}
+		search_last[bus] = search_discrepancy[bus];
+		if (crc8(search_rom[bus], 8) == 0) {
+			for (uint8_t i = 0; i < device_count; i++) {
+				uint8_t j = 0;
+				while (j < 8 && devices[i].rom[j] == search_rom[bus][j]) j++;
+				if (j == 8 && devices[i].bus == bus) devices[i].alarm = TRUE;
+			}
+		}
+		if (search_last[bus] < 0) search_buses &= ~(1 << bus);
+	}
+	update_engine_pins();
+	if (engine_pins) {
+		engine_step = arg;
+		engine_phase = 0;
+	} else {
+		alarm_search_end();
+	}
+}
+
+/**
+  * @brief Ends the ALARM SEARCH. Devices without valid value, and every device each
+  * 	   ALARM_REFRESH periods, are read too. A device without alarm keeps its value,
+  * 	   so the first device counts as read then.
+  * @retval None
+  */
+void alarm_search_end() {
+	uint8_t refresh = (alarm_refresh == 0);
+
+	alarm_refresh = (refresh ? ALARM_REFRESH : alarm_refresh) - 1;
+	for (uint8_t i = 0; i < device_count; i++) {
+		if (refresh || !devices[i].valid) devices[i].alarm = TRUE;
+	}
+	if (!devices[0].alarm && (engine_present >> devices[0].bus & 1)) {
+		engine_has_result = TRUE;
+		sample_tick = conversion_tick;					// value is still inside its window
+	}
+	engine_searching = FALSE;
+	engine_alarm_only = TRUE;
+	restart_devices();
+	next_step();
+}
+
+/**
+  * @brief Clears the alarm of the current devices after their window was
+  * 	   re-centred and moves every bus on to its next device with alarm.
+  * @param uint8_t arg step to jump back to for the next devices
+  * @retval uint16_t 0, next step can be processed immediately
+  */
+uint16_t next_alarm(uint8_t arg) {
+	uint8_t more = FALSE;
+
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		uint8_t index = engine_device[bus];
+		if (!(engine_pins & bus_pins[bus])) continue;
+		devices[index].alarm = FALSE;
+		engine_device[bus] = first_device(bus, index + 1);
+		if (engine_device[bus] != NO_DEVICE) more = TRUE;
+	}
+	if (more) {
+		update_engine_pins();
+		engine_step = arg;
+		engine_phase = 0;
+		return 0;
+	}
+	engine_alarm_only = FALSE;
+	restart_devices();
+	next_step();
+	return 0;
+}
+#endif /* ONEWIRE_ALARM_WINDOW */
+
+/**
+  * @brief Returns how long to wait till the conversion should be done, without
+  * 	   any bus traffic. Waits longer than a timer period are split.
+  * @retval uint16_t time in us, 0 if the conversion time has passed
+  */
+uint16_t conversion_wait() {
+	uint32_t elapsed = HAL_GetTick() - conversion_tick;
+	uint32_t remaining;
+
+	if (elapsed >= engine_conversion_time) return 0;
+	remaining = (engine_conversion_time - elapsed) * 1000;
+	return (remaining > TIMER_WAIT_MAX ? TIMER_WAIT_MAX : remaining);
+}
+
+/**
+  * @brief Ends the conversion wait after a read slot, once every bus has read 1.
+  * 	   Buses that missed the CONVERT T would only return an old result, buses
+  * 	   still reading 0 after the conversion timeout of the resolution are stuck
+  * 	   low. Both are dropped and the other buses go on, the reading only fails
+  * 	   if no bus is left.
+  * @param uint16_t converted pins of the buses that read 1 in the read slot
+  * @retval uint16_t time in us till the next read slot or step
+  */
+uint16_t conversion_polled(uint16_t converted) {
+	uint16_t waiting;
+
+	drop_buses(engine_pins & ~conversion_pins);
+	engine_converted |= converted;
+	waiting = engine_pins & ~engine_converted;
+	if (waiting) {										// DS1820 still converting or bus stuck low
+		if (HAL_GetTick() - conversion_tick <= CONVERSION_TIMEOUT(engine_conversion_time)) {
+			return CONVERSION_POLL;
+		}
+		drop_buses(waiting);
+	}
+	if (!engine_pins) {
+		engine_state = ENGINE_FAILED;
+		return 0;
+	}
+	engine_converted = 0;
+	next_step();
+	return READ_RECOVER;
+}
+
+#ifndef ONEWIRE_UART
+/**
+  * @brief Processes the next part of the current step. Long bus states are timed by
+  * 	   the timer, only states shorter than a few us (write 1, read slot) are waited
+  * 	   for inside the interrupt, so no other interrupt can stretch them.
+  * 	   All buses in engine_pins are driven by one write and sampled by one read
+  * 	   of the port, so K buses take the time of one.
+  * 	   Steps are split in phases:
+  * 	   		- STEP_RESET: 0 check for short and pull low, 1 release, 2 sample presence
+  * 	   		- STEP_WRITE, STEP_SELECT: two phases per bit, second one only used if a bus sends 0
+  * 	   		- STEP_READ: one phase per bit
+  * 	   		- STEP_ALARM_SEARCH: 0 and 1 read slots, 2 write direction, 3 end of 0 slot
+  * @retval uint16_t time in us till this function has to be called again,
+  * 		   0 if the next step can be processed immediately
+  */
+uint16_t process_step() {
+	uint8_t step = engine_program[engine_step][0];
+	uint8_t arg = engine_program[engine_step][1];
+
+	switch (step) {
+		case STEP_RESET:
+			if (engine_phase == 0) {
+				uint16_t probe = (engine_resets == 0 ? probe_pins() : 0);
+				uint16_t shorted = (engine_pins | probe) & ~gpio_read(OneWire_DS1820_GPIO_Port, engine_pins | probe);
+				update_presence(shorted, 0);
+				drop_buses(shorted);							// bus shorted to ground
+				engine_pins |= probe & ~shorted;
+				if (!engine_pins) {
+					engine_state = ENGINE_FAILED;
+					return 0;
+				}
+				gpio_reset(OneWire_DS1820_GPIO_Port, engine_pins);
+				engine_phase = 1;
+				return RESET;
+			}
+			if (engine_phase == 1) {
+				gpio_set(OneWire_DS1820_GPIO_Port, engine_pins);
+				engine_phase = 2;
+				return PRESENCE_WAIT;
+			}
+			update_presence(engine_pins, engine_pins & ~gpio_read(OneWire_DS1820_GPIO_Port, engine_pins));
+			drop_buses(gpio_read(OneWire_DS1820_GPIO_Port, engine_pins));	// no device pulled the bus low, probed buses end here
+			if (!engine_pins) {
+				engine_state = ENGINE_FAILED;			// fails ~1 ms after start
+				return 0;
+			}
+			engine_resets++;
+			next_step();
+			return PRESENCE_RECOVER;
+
+		case STEP_WRITE:
+		case STEP_SELECT:
+		case STEP_WRITE_ALARM: {
+			uint16_t time;
+			if (engine_phase == 0) load_tx(step, arg);
+			if (engine_phase & 1) {						// end of 0 slots
+				gpio_set(OneWire_DS1820_GPIO_Port, engine_pins);
+				engine_phase++;
+				time = SEND_SHORT;
+			} else {
+				uint8_t index = engine_phase >> 4;
+				uint8_t bit = engine_phase >> 1 & 7;
+				uint16_t ones = 0;
+				for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+					if ((engine_pins & bus_pins[bus]) && (engine_tx[bus][index] >> bit & 1)) ones |= bus_pins[bus];
+				}
+				gpio_reset(OneWire_DS1820_GPIO_Port, engine_pins);
+				delayUs(SEND_SHORT);
+				if (ones) gpio_set(OneWire_DS1820_GPIO_Port, ones);
+				if (ones != engine_pins) {				// buses sending 0 stay low
+					engine_phase++;
+					return SEND_LONG - SEND_SHORT;
+				}
+				engine_phase += 2;						// 1 slots are done completely here
+				time = SEND_LONG;
+			}
+			if (engine_phase == engine_tx_len * 16) {
+				if (step == STEP_WRITE && arg == CONVERT_T) {
+					conversion_tick = HAL_GetTick();
+					conversion_pins = engine_pins;
+				}
+				next_step();
+			}
+			return time;
+		}
+
+		case STEP_READ: {
+			uint16_t sample;
+			if (engine_phase == 0) engine_read_len = (arg ? arg : engine_read_length());
+			sample = read_slot_pins(engine_pins);
+			for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+				if (sample & bus_pins[bus]) engine_scratchpad[bus][engine_phase >> 3] |= 1 << (engine_phase & 7);
+			}
+			engine_phase++;
+			if (engine_phase == engine_read_len * 8) {
+				engine_bus_saved += (9 - engine_read_len) * 8 * READ_SLOT;
+				next_step();
+			}
+			return READ_RECOVER;
+		}
+
+		case STEP_RELEASE:
+			if (engine_read_len == 9) {					// DS1820 already finished sending
+				next_step();
+				return 0;
+			}
+			if (engine_phase == 0) {
+				gpio_reset(OneWire_DS1820_GPIO_Port, engine_pins);
+				engine_bus_saved -= RESET_SLOT;
+				engine_phase = 1;
+				return RESET;
+			}
+			gpio_set(OneWire_DS1820_GPIO_Port, engine_pins);
+			next_step();
+			return PRESENCE_WAIT + PRESENCE_RECOVER;
+
+		case STEP_NEXT_DEVICE:
+			return next_device(arg);
+
+		case STEP_WAIT_CONVERSION: {
+			uint16_t wait = conversion_wait();			// no bus traffic till conversion should be done
+			if (wait) return wait;
+			return conversion_polled(read_slot_pins(engine_pins & conversion_pins & ~engine_converted));
+		}
+
+		case STEP_SKIP_IF_NO_DEVICE:
+			return skip_if_no_device(arg);
+
+#ifdef ONEWIRE_ALARM_WINDOW
+		case STEP_ALARM_SEARCH: {
+			uint16_t pins = 0;
+			uint16_t ones = 0;
+			uint16_t time = SEND_LONG;
+			if (engine_phase < 2) {						// read bit and its complement
+				uint16_t sample = read_slot_pins(engine_pins);
+				if (engine_phase == 0 && search_index == 0) {
+					search_idle = 0;
+					for (uint8_t bus = 0; bus < BUS_COUNT; bus++) search_discrepancy[bus] = -1;
+				}
+				if (engine_phase == 0) search_bits = sample;
+				else search_complements = sample;
+				engine_phase++;
+				return READ_RECOVER;
+			}
+			if (engine_phase == 2) {					// write direction, like STEP_WRITE
+				for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+					uint8_t direction;
+					if (!(engine_pins & bus_pins[bus]) || (search_idle >> bus & 1)) continue;
+					direction = search_direction(bus, search_index, (search_bits & bus_pins[bus]) != 0,
+							(search_complements & bus_pins[bus]) != 0);
+					if (direction == 2) {
+						search_idle |= 1 << bus;
+						continue;
+					}
+					pins |= bus_pins[bus];
+					if (direction) ones |= bus_pins[bus];
+				}
+				if (!pins) {							// no bus has a device with alarm left
+					search_index = 0;
+					alarm_pass_end(arg);
+					return 0;
+				}
+				gpio_reset(OneWire_DS1820_GPIO_Port, pins);
+				delayUs(SEND_SHORT);
+				if (ones) gpio_set(OneWire_DS1820_GPIO_Port, ones);
+				if (ones != pins) {
+					engine_phase = 3;
+					return SEND_LONG - SEND_SHORT;
+				}
+			} else {									// end of 0 slots
+				gpio_set(OneWire_DS1820_GPIO_Port, engine_pins);
+				time = SEND_SHORT;
+			}
+			engine_phase = 0;
+			if (++search_index == 64) {
+				search_index = 0;
+				alarm_pass_end(arg);
+			}
+			return time;
+		}
+
+		case STEP_NEXT_ALARM:
+			return next_alarm(arg);
+#endif
+	}
+	return 0;
+}
+#else
+/**
+  * @brief Processes the next part of the current step with the UART transport.
+  * 	   Bus states are generated by the USART and moved by DMA, the engine waits
+  * 	   for onewire_transfer_complete() then. Only the conversion wait and the
+  * 	   retry backoff are timed by the timer.
+  * 	   Steps are split in phases:
+  * 	   		- all bus steps: 0 start transfer, 1 evaluate transfer
+  * 	   		- STEP_ALARM_SEARCH: 0 read slots, 1 write direction, 2 next bit
+  * 	   		- STEP_WAIT_CONVERSION: 0 wait or start read slot, 1 evaluate read slot
+  * @retval uint16_t time in us till this function has to be called again,
+  * 		   0 if the next step can be processed immediately,
+  * 		   WAIT_TRANSFER if a transfer was started
+  */
+uint16_t process_step() {
+	uint8_t step = engine_program[engine_step][0];
+	uint8_t arg = engine_program[engine_step][1];
+
+	switch (step) {
+		case STEP_RESET:
+			if (engine_phase == 0) {
+				onewire_uart_start_reset();
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			if (!onewire_uart_presence()) {
+				update_presence(bus_pins[0], 0);
+				engine_state = ENGINE_FAILED;			// no presence pulse or bus shorted
+				return 0;
+			}
+			update_presence(bus_pins[0], bus_pins[0]);
+			engine_resets++;
+			next_step();
+			return 0;
+
+		case STEP_WRITE:
+		case STEP_SELECT:
+		case STEP_WRITE_ALARM:
+			if (engine_phase == 0) {
+				load_tx(step, arg);
+				onewire_uart_start_bits(engine_tx[0], engine_tx_len * 8);
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			if (step == STEP_WRITE && arg == CONVERT_T) {
+				conversion_tick = HAL_GetTick();
+				conversion_pins = engine_pins;
+			}
+			next_step();
+			return 0;
+
+		case STEP_READ:
+			if (engine_phase == 0) {
+				engine_read_len = (arg ? arg : engine_read_length());
+				onewire_uart_start_bits(NULL, engine_read_len * 8);
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			onewire_uart_get_bits(engine_scratchpad[0], engine_read_len * 8);
+			engine_bus_saved += (9 - engine_read_len) * 8 * READ_SLOT;
+			next_step();
+			return 0;
+
+		case STEP_RELEASE:
+			if (engine_read_len == 9) {					// DS1820 already finished sending
+				next_step();
+				return 0;
+			}
+			if (engine_phase == 0) {
+				onewire_uart_start_reset();
+				engine_bus_saved -= RESET_SLOT;
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			next_step();
+			return 0;
+
+		case STEP_NEXT_DEVICE:
+			return next_device(arg);
+
+		case STEP_WAIT_CONVERSION: {
+			uint8_t bit;
+			if (engine_phase == 0) {
+				uint16_t wait = conversion_wait();		// no bus traffic till conversion should be done
+				if (wait) return wait;
+				onewire_uart_start_bits(NULL, 1);
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			engine_phase = 0;
+			onewire_uart_get_bits(&bit, 1);
+			return conversion_polled(bit ? engine_pins : 0);
+		}
+
+		case STEP_SKIP_IF_NO_DEVICE:
+			return skip_if_no_device(arg);
+
+#ifdef ONEWIRE_ALARM_WINDOW
+		case STEP_ALARM_SEARCH: {
+			uint8_t bits;
+			if (engine_phase == 0) {					// read bit and its complement
+				if (search_index == 0) {
+					search_idle = 0;
+					search_discrepancy[0] = -1;
+				}
+				onewire_uart_start_bits(NULL, 2);
+				engine_phase = 1;
+				return WAIT_TRANSFER;
+			}
+			if (engine_phase == 1) {					// write direction
+				onewire_uart_get_bits(&bits, 2);
+				bits = search_direction(0, search_index, bits & 1, bits >> 1 & 1);
+				if (bits == 2) {						// no device with alarm left
+					search_idle = 1;
+					search_index = 0;
+					alarm_pass_end(arg);
+					return 0;
+				}
+				onewire_uart_start_bits(&bits, 1);
+				engine_phase = 2;
+				return WAIT_TRANSFER;
+			}
+			engine_phase = 0;
+			if (++search_index == 64) {
+				search_index = 0;
+				alarm_pass_end(arg);
+			}
+			return 0;
+		}
+
+		case STEP_NEXT_ALARM:
+			return next_alarm(arg);
+#endif
+	}
+	return 0;
+}
+#endif /* ONEWIRE_UART */
+
+/**
+  * @brief Processes steps till one has to wait, then arms the timer or waits for
+  * 	   the UART transfer. Called in interrupt context.
+  * @retval None
+  */
+void run_engine() {
+#ifdef BENCHMARK_ENABLED
+	uint32_t start = bench_cycles();
+#endif
+	if (engine_state == ENGINE_BUSY) {
+		uint16_t time = 0;
+		while (time == 0 && engine_state == ENGINE_BUSY && engine_program[engine_step][0] != STEP_END) {
+			time = process_step();
+		}
+		if (engine_state == ENGINE_FAILED) finish_reading(ENGINE_FAILED);
+		else if (engine_program[engine_step][0] == STEP_END) finish_reading(ENGINE_DONE);
+		else if (time == WAIT_TRANSFER) __HAL_TIM_DISABLE(onewire_htim);
+		else arm_timer(time);
+	}
+#ifdef BENCHMARK_ENABLED
+	engine_isr_cycles += bench_cycles() - start;
+#endif
+}
+
+/**
+  * @brief Has to be called by the period elapsed callback of the timer given to
+  * 	   onewire_init(). Processes the current step and arms the timer for the next one.
+  * @retval None
+  */
+void onewire_timer_tick() {
+	run_engine();
+}
+
+/**
+  * @brief Called by the UART transport when a transfer started by the engine
+  * 	   has finished. Processes the next steps. Called in interrupt context.
+  * @retval None
+  */
+void onewire_transfer_complete() {
+	run_engine();
+}
+
+/**
+  * @brief Starts processing the given program in the timer interrupt.
+  * @param program program to process, has to end with STEP_END
+  * @param callback function called in interrupt context when the program ended
+  * @retval uint8_t TRUE if the program was started, FALSE if engine is busy
+  */
+uint8_t start_program(const uint8_t (*program)[2], void (*callback)(int16_t temperature, uint8_t valid)) {
+	if (engine_state != ENGINE_IDLE) return FALSE;
+
+	clear_scratchpad();
+	engine_alarm_only = FALSE;
+	engine_searching = FALSE;
+	engine_resets = 0;
+	for (uint8_t bus = 0; bus < BUS_COUNT; bus++) {
+		engine_device[bus] = first_device(bus, 0);
+		engine_retry[bus] = 0;
+	}
+	engine_present = (1 << BUS_COUNT) - 1;
+	engine_converted = 0;
+	update_engine_pins();
+#ifdef ONEWIRE_ALARM_WINDOW
+	if (program == alarm_program) alarm_start();
+#endif
+	engine_bus_saved = 0;
+	engine_conversion_time = conversion_time();
+	engine_has_result = FALSE;
+	engine_callback = callback;
+	engine_program = program;
+	engine_step = 0;
+	engine_phase = 0;
+	engine_state = ENGINE_BUSY;
+
+	arm_timer(2);										// first step is processed by the timer interrupt
+	__HAL_TIM_CLEAR_FLAG(onewire_htim, TIM_FLAG_UPDATE);
+	HAL_TIM_Base_Start_IT(onewire_htim);
+	return TRUE;
+}
+
+/**
+  * @brief Starts an interrupt driven temperature reading and returns immediately.
+  * 	   Follows the same protocol as get_temperature(), the busy waits are replaced
+  * 	   by timer interrupts. Result is fetched by complete_temperature().
+  * @param callback function called in interrupt context when the reading ended,
+  * 		   gets the temperature and TRUE if it is valid. May be NULL.
+  * @retval uint8_t TRUE if the reading was started, FALSE if one is still in progress
+  */
+uint8_t start_temperature(void (*callback)(int16_t temperature, uint8_t valid)) {
+	return start_program(reading_program, callback);
+}
+
+/**
+  * @brief Starts the next step of the pipelined reading and returns immediately.
+  * 	   The conversion runs between two calls, so it has to be called periodically
+  * 	   with a period of at least the conversion time:
+  * 	   		- first call: CONVERT T only, complete_temperature() returns FALSE
+  * 	   		- further calls: READ SCRATCHPAD of the previous conversion, then
+  * 	   		  CONVERT T for the next call
+  * 	   The returned sample is one period old, see get_temperature_age().
+  * 	   After a failed transaction the pipeline starts over with CONVERT T.
+  * 	   With ONEWIRE_ALARM_WINDOW, only devices found by ALARM SEARCH are read.
+  * @param callback function called in interrupt context when the transaction ended
+  * @retval uint8_t TRUE if the transaction was started, FALSE if one is still in progress
+  */
+uint8_t start_temperature_pipelined(void (*callback)(int16_t temperature, uint8_t valid)) {
+#ifdef ONEWIRE_ALARM_WINDOW
+	if (conversion_pending && device_count > 0) return start_program(alarm_program, callback);
+#endif
+	if (conversion_pending) return start_program(read_and_convert_program, callback);
+	return start_program(convert_program, callback);
+}
+
+/**
+  * @brief Returns the bus time saved by truncated scratchpad reads during the
+  * 	   last finished program, compared to reading all 9 bytes of every device.
+  * 	   Includes the cost of reset pulses needed to end truncated reads.
+  * @retval int32_t saved bus time in us, negative if the reset pulses cost more
+  */
+int32_t get_bus_time_saved() {
+	return bus_time_saved;
+}
+
+/**
+  * @brief Returns the bus transactions saved by the alarm poll mode, summed over
+  * 	   all readings. A transaction starts with a reset pulse. Full polling needs
+  * 	   one per device and one for CONVERT T, the alarm program one per search
+  * 	   pass and two per alarming device (read and re-centre) on top.
+  * @retval int32_t saved transactions, negative if alarms cost more, 0 without ONEWIRE_ALARM_WINDOW
+  */
+int32_t get_transactions_saved() {
+#ifdef ONEWIRE_ALARM_WINDOW
+	return transactions_saved;
+#else
+	return 0;
+#endif
+}
+
+/**
+  * @brief Returns the age of the last valid temperature, measured from the start of
+  * 	   its conversion. Used to detect stale values.
+  * @retval uint32_t age in ms, 0xFFFFFFFF if there was no valid reading yet
+  */
+uint32_t get_temperature_age() {
+	if (!sample_available) return 0xFFFFFFFF;
+	return HAL_GetTick() - sample_tick;
+}
+
+/**
+  * @brief Tells if any bus answered its last reset pulse. Readings keep sending
+  * 	   reset pulses on missing buses, so a reconnected sensor is noticed by the
+  * 	   next reading.
+  * @retval uint8_t TRUE if a presence pulse was received on any bus, FALSE otherwise
+  */
+uint8_t is_sensor_present() {
+	return buses_present != 0;
+}
+
+/**
+  * @brief Tells if the bus of a device answered its last reset pulse, so the
+  * 	   display can mark a single sensor as missing. With an empty device
+  * 	   table, index 0 stands for the device on the first bus.
+  * @param uint8_t index index in device table
+  * @retval uint8_t TRUE if its bus is present, FALSE otherwise
+  */
+uint8_t is_device_present(uint8_t index) {
+	uint8_t bus = (index < device_count ? devices[index].bus : 0);
+
+	return buses_present >> bus & 1;
+}
+
+/**
+  * @brief Tells if no reading is in progress, so neither the timer nor the bus
+  * 	   are needed. A DS1820 may still be converting on its own.
+  * @retval uint8_t TRUE if idle, FALSE while a reading runs or its result isn't fetched
+  */
+uint8_t is_onewire_idle() {
+	return engine_state == ENGINE_IDLE;
+}
+
+/**
+  * @brief Refreshes the device table with search_devices(), if a sensor answered
+  * 	   again after it was missing. Has to be called periodically from the main
+  * 	   loop. Does nothing while a reading is in progress, otherwise only blocks
+  * 	   when a sensor was plugged in. The pipeline starts over with CONVERT T.
+  * @retval uint8_t TRUE if the device table was refreshed, FALSE otherwise
+  */
+uint8_t onewire_hotplug_poll() {
+	if (!rescan_pending || engine_state != ENGINE_IDLE) return FALSE;
+	rescan_pending = FALSE;
+	search_devices();
+	conversion_pending = FALSE;
+#ifdef ONEWIRE_ALARM_WINDOW
+	alarm_refresh = 0;									// new devices get their window with the next reading
+#endif
+	return TRUE;
+}
+
+/**
+  * @brief Checks if the reading started by start_temperature() has ended.
+  * @retval uint8_t TRUE if complete_temperature() can be called, FALSE otherwise
+  */
+uint8_t poll_temperature() {
+	return engine_state == ENGINE_DONE || engine_state == ENGINE_FAILED;
+}
+
+/**
+  * @brief Fetches the result of an ended reading and allows to start the next one.
+  * @param int16_t* temperature is set to the temperature in degrees C * 10, only
+  * 		   if the reading was successful
+  * @retval uint8_t TRUE if temperature was set, FALSE if reading failed or hasn't ended
+  */
+uint8_t complete_temperature(int16_t* temperature) {
+	uint8_t state = engine_state;
+
+	if (state != ENGINE_DONE && state != ENGINE_FAILED) return FALSE;
+	if (state == ENGINE_DONE) *temperature = engine_temperature;
+	engine_state = ENGINE_IDLE;
+	return state == ENGINE_DONE;
+}
+
+/**
+  * @brief Measures how long the main loop is blocked by one temperature reading.
+  * 	   First with the blocking get_temperature(), then with the interrupt driven
+  * 	   reading, where only start_temperature() and complete_temperature() run
+  * 	   in the main loop. Time spent in the timer interrupt is recorded separately.
+  * 	   Results are stored in bench_results. Must only be called while no
+  * 	   interrupt driven reading is in progress.
+  * @retval None
+  */
+void benchmark_temperature_reading() {
+#ifdef BENCHMARK_ENABLED
+	int16_t temperature;
+	uint32_t main_cycles;
+	uint32_t start = bench_cycles();
+
+	get_temperature();
+	bench_record(BENCH_TEMP_BLOCKING, bench_cycles() - start);
+
+	engine_isr_cycles = 0;
+	start = bench_cycles();
+	start_temperature(NULL);
+	main_cycles = bench_cycles() - start;
+	while (!poll_temperature());						// main loop would do other work here
+	start = bench_cycles();
+	complete_temperature(&temperature);
+	main_cycles += bench_cycles() - start;
+	bench_record(BENCH_TEMP_ASYNC_MAIN, main_cycles);
+	bench_record(BENCH_TEMP_ASYNC_ISR, engine_isr_cycles);
+#endif
+}
+
+/**
+  * @brief Measures the cycles to release and sample the 1wire pin, the core of
+  * 	   every read slot, with the HAL and with gpio_lib.h. Each variant runs
+  * 	   PIN_BENCH_CALLS times, the average is recorded in bench_results. The bus
+  * 	   is only released, so devices don't notice. GPIO mode only.
+  * @retval None
+  */
+void benchmark_pin_access() {
+#if defined(BENCHMARK_ENABLED) && !defined(ONEWIRE_UART)
+	volatile uint16_t level = 0;						// keeps the reads from being optimized away
+	uint32_t start = bench_cycles();
+
+	for (uint8_t i = 0; i < PIN_BENCH_CALLS; i++) {
+		HAL_GPIO_WritePin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin, GPIO_PIN_SET);
+		level = HAL_GPIO_ReadPin(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin);
+	}
+	bench_record(BENCH_PIN_HAL, (bench_cycles() - start) / PIN_BENCH_CALLS);
+
+	start = bench_cycles();
+	for (uint8_t i = 0; i < PIN_BENCH_CALLS; i++) {
+		gpio_set(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin);
+		level = gpio_read(OneWire_DS1820_GPIO_Port, OneWire_DS1820_Pin);
+	}
+	bench_record(BENCH_PIN_FAST, (bench_cycles() - start) / PIN_BENCH_CALLS);
+	(void) level;
+#endif
+}
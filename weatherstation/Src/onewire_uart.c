@@ -0,0 +1,252 @@
+/**
+  ******************************************************************************
+  * @file           : onewire_uart.c
+  * @brief          : Implements Functions to generate 1wire slots with a USART
+  * 				  in single wire half duplex mode
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+#include "onewire_uart.h"
+
+/* Used for onewire_transfer_complete() ----------------------------------------*/
+#include "onewire_DS1820.h"
+
+#ifdef ONEWIRE_UART
+
+/*
+ * The USART TX pin is the 1wire bus (open drain, external pull up). In half
+ * duplex mode the receiver reads back the bus, so every sent byte returns as
+ * echo, with all bits a device pulled low cleared.
+ */
+
+/* Baud rates ----------------------------------------------------------------*/
+#define BAUD_RESET			9600	// start bit + 4 zero bits = 520 us reset pulse
+#define BAUD_DATA			115200	// start bit = 8.7 us low, one byte = one slot
+
+/* UART bytes that form the 1wire slots --------------------------------------*/
+#define RESET_BYTE			0xF0	// echo unchanged if no presence pulse
+#define SLOT_1				0xFF	// write 1 and read slot, echo unchanged if 1 was read
+#define SLOT_0				0x00	// write 0 slot, bus is low for 78 us
+
+/* Longest transfer, MATCH ROM + ROM code or a full scratchpad -----------------*/
+#define MAX_SLOTS			72
+
+/* Errors cleared before each transfer, echoes of a shorted bus cause them -----*/
+#define UART_ERRORS			(USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF)
+
+/*
+ * UART and DMA channels, USART2 TX is served by channel 4, RX by channel 5.
+ */
+UART_HandleTypeDef* onewire_huart;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_usart2_rx;
+
+/*
+ * One UART byte per 1wire slot. TX DMA reads a byte before its echo is
+ * received, so the echoes are written back into the same buffer.
+ */
+uint8_t slots[MAX_SLOTS];
+uint8_t reset_transfer = FALSE;			// TRUE while a reset at BAUD_RESET is transferred
+
+/* Private prototypes --------------------------------------------------------*/
+void set_baud(uint32_t baud);
+void clear_receiver();
+uint8_t transfer_byte(uint8_t byte);
+void start_transfer(uint8_t count);
+void transfer_complete(DMA_HandleTypeDef* hdma);
+
+/**
+  * @brief Switches the UART to single wire half duplex mode with BAUD_DATA,
+  * 	   reconfigures TX as open drain and sets up the DMA channels. Has to be
+  * 	   called once after the UART was initialized by CubeMX code.
+  * @param UART_HandleTypeDef* huart USART2 handle, TX pin is connected to the bus
+  * @retval None
+  */
+void onewire_uart_init(UART_HandleTypeDef* huart) {
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	onewire_huart = huart;
+	huart->Init.BaudRate = BAUD_DATA;
+	HAL_HalfDuplex_Init(huart);
+
+	/* 1wire needs open drain, pull up is external */
+	GPIO_InitStruct.Pin = USART_TX_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = GPIO_AF1_USART2;
+	HAL_GPIO_Init(USART_TX_GPIO_Port, &GPIO_InitStruct);
+
+	__HAL_RCC_DMA1_CLK_ENABLE();
+
+	hdma_usart2_tx.Instance = DMA1_Channel4;
+	hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+	hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+	HAL_DMA_Init(&hdma_usart2_tx);
+
+	hdma_usart2_rx.Instance = DMA1_Channel5;
+	hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+	hdma_usart2_rx.Init.Mode = DMA_NORMAL;
+	hdma_usart2_rx.Init.Priority = DMA_PRIORITY_HIGH;
+	HAL_DMA_Init(&hdma_usart2_rx);
+	hdma_usart2_rx.XferCpltCallback = transfer_complete;
+
+	/* Same priority as the 1wire timer, so they can't interrupt each other */
+	HAL_NVIC_SetPriority(DMA1_Channel4_5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel4_5_IRQn);
+}
+
+/**
+  * @brief Sets a new baud rate. Waits till the last byte was sent, because the
+  * 	   UART has to be disabled to change the baud rate register.
+  * @param uint32_t baud new baud rate
+  * @retval None
+  */
+void set_baud(uint32_t baud) {
+	while (!(onewire_huart->Instance->ISR & USART_ISR_TC));
+	__HAL_UART_DISABLE(onewire_huart);
+	onewire_huart->Instance->BRR = UART_DIV_SAMPLING16(HAL_RCC_GetPCLK1Freq(), baud);
+	__HAL_UART_ENABLE(onewire_huart);
+}
+
+/**
+  * @brief Drops received bytes and clears errors left by the last transfer.
+  * @retval None
+  */
+void clear_receiver() {
+	onewire_huart->Instance->ICR = UART_ERRORS;
+	while (onewire_huart->Instance->ISR & USART_ISR_RXNE) {
+		(void) onewire_huart->Instance->RDR;
+	}
+}
+
+/**
+  * @brief Sends one byte and waits for its echo. Blocking, the echo arrives
+  * 	   one byte time later, even if the bus is shorted.
+  * @param uint8_t byte byte to send
+  * @retval uint8_t echo read back from the bus
+  */
+uint8_t transfer_byte(uint8_t byte) {
+	clear_receiver();
+	onewire_huart->Instance->TDR = byte;
+	while (!(onewire_huart->Instance->ISR & USART_ISR_RXNE));
+	return onewire_huart->Instance->RDR;
+}
+
+/**
+  * @brief Sends a reset pulse and samples the presence pulse. Blocking, ~1 ms.
+  * 	   The presence pulse ends 820 us after start of reset at the latest, so
+  * 	   the last bit of the echo is only cleared if the bus is shorted.
+  * @retval uint8_t TRUE if a presence pulse was received, FALSE otherwise
+  */
+uint8_t onewire_uart_reset() {
+	uint8_t echo;
+
+	set_baud(BAUD_RESET);
+	echo = transfer_byte(RESET_BYTE);
+	set_baud(BAUD_DATA);
+	return echo != RESET_BYTE && (echo & 0x80);
+}
+
+/**
+  * @brief Creates one write slot or read slot. Blocking, ~87 us.
+  * @param uint8_t bit bit to write, 1 for a read slot
+  * @retval uint8_t bit read from the bus
+  */
+uint8_t onewire_uart_bit(uint8_t bit) {
+	return transfer_byte(bit ? SLOT_1 : SLOT_0) == SLOT_1;
+}
+
+/**
+  * @brief Starts a DMA transfer of the first count bytes of slots, the echoes
+  * 	   replace them. transfer_complete() is called when the last echo arrived.
+  * @param uint8_t count number of bytes to transfer
+  * @retval None
+  */
+void start_transfer(uint8_t count) {
+	USART_TypeDef* usart = onewire_huart->Instance;
+
+	clear_receiver();
+	HAL_DMA_Start_IT(&hdma_usart2_rx, (uint32_t) &usart->RDR, (uint32_t) slots, count);
+	HAL_DMA_Start(&hdma_usart2_tx, (uint32_t) slots, (uint32_t) &usart->TDR, count);
+	SET_BIT(usart->CR3, USART_CR3_DMAR | USART_CR3_DMAT);
+}
+
+/**
+  * @brief Called by the RX DMA channel, after the echo of the last byte was received.
+  * 	   Called in interrupt context.
+  * @param DMA_HandleTypeDef* hdma RX DMA handle
+  * @retval None
+  */
+void transfer_complete(DMA_HandleTypeDef* hdma) {
+	CLEAR_BIT(onewire_huart->Instance->CR3, USART_CR3_DMAR | USART_CR3_DMAT);
+	HAL_DMA_Abort(&hdma_usart2_tx);						// finished before the last echo, releases the channel
+	if (reset_transfer) {
+		set_baud(BAUD_DATA);
+		reset_transfer = FALSE;
+	}
+	onewire_transfer_complete();
+}
+
+/**
+  * @brief Starts a reset pulse by DMA and returns immediately.
+  * 	   Result is fetched by onewire_uart_presence().
+  * @retval None
+  */
+void onewire_uart_start_reset() {
+	set_baud(BAUD_RESET);
+	reset_transfer = TRUE;
+	slots[0] = RESET_BYTE;
+	start_transfer(1);
+}
+
+/**
+  * @brief Returns the presence pulse of the last reset started by onewire_uart_start_reset().
+  * @retval uint8_t TRUE if a presence pulse was received, FALSE otherwise
+  */
+uint8_t onewire_uart_presence() {
+	return slots[0] != RESET_BYTE && (slots[0] & 0x80);
+}
+
+/**
+  * @brief Starts write slots or read slots by DMA and returns immediately.
+  * 	   Bits are sent LSB first. Read bits are fetched by onewire_uart_get_bits().
+  * @param const uint8_t* bytes bits to write, NULL for read slots only
+  * @param uint8_t bits number of slots, at most MAX_SLOTS
+  * @retval None
+  */
+void onewire_uart_start_bits(const uint8_t* bytes, uint8_t bits) {
+	if (bits > MAX_SLOTS) bits = MAX_SLOTS;
+	for (uint8_t i = 0; i < bits; i++) {
+		slots[i] = (bytes == NULL || (bytes[i >> 3] >> (i & 7) & 1)) ? SLOT_1 : SLOT_0;
+	}
+	start_transfer(bits);
+}
+
+/**
+  * @brief Collects the bits read by the last transfer started by onewire_uart_start_bits().
+  * @param uint8_t* bytes is filled with the read bits, LSB first
+  * @param uint8_t bits number of slots that were transferred
+  * @retval None
+  */
+void onewire_uart_get_bits(uint8_t* bytes, uint8_t bits) {
+	for (uint8_t i = 0; i < bits; i++) {
+		if ((i & 7) == 0) bytes[i >> 3] = 0;
+		bytes[i >> 3] |= (slots[i] == SLOT_1) << (i & 7);
+	}
+}
+
+#endif /* ONEWIRE_UART */
@@ -0,0 +1,225 @@
+/**
+  ******************************************************************************
+  * @file           : power.c
+  * @brief          : Implements the idle path of the main loop with Sleep and
+  * 				  Stop mode
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "power.h"
+
+/* Used for scheduler_now_us() and scheduler_advance() -----------------------*/
+#include "scheduler.h"
+
+/*
+ * The STM32F030x8 has neither an RTC wakeup timer nor a low power timer, so
+ * Stop mode is left by alarm A. Only the subseconds are compared, the alarm
+ * matches when the subsecond down counter reaches the value it has after the
+ * idle time, so it can't be longer than a second.
+ */
+
+/* Duty cycle and currents of the last window --------------------------------*/
+struct Power_stats power_stats;
+
+/*
+ * RTC and the functions called right before entering and right after leaving
+ * Stop mode, e.g. to restore the system clock.
+ */
+RTC_HandleTypeDef* power_hrtc = NULL;
+void (*power_stop_enter)() = NULL;
+void (*power_stop_exit)() = NULL;
+uint32_t rtc_steps = 0;					// RTC subseconds per second
+uint32_t rtc_step_us = 0;				// length of an RTC subsecond in us
+
+/*
+ * Idle time and entries of every mode since the window was started. The
+ * HAL tick doesn't count while idle, tick_rest_us is the part of the idle
+ * time not yet added to it.
+ */
+uint32_t window_start = 0;				// HAL tick the window was started at
+uint32_t idle_us[Power_modes];
+uint16_t idle_entries[Power_modes];
+uint32_t tick_rest_us = 0;
+
+/* Private prototypes --------------------------------------------------------*/
+uint32_t rtc_now();
+uint32_t enter_sleep();
+uint32_t enter_stop(uint32_t stop_us);
+void account(enum Power_mode mode, uint32_t us);
+
+/**
+  * @brief Sets the RTC used to wake from Stop mode and starts the first window.
+  * 	   stop_exit has to restore the system clock, the core runs from HSI
+  * 	   with 8 MHz after Stop mode. Both are called with interrupts disabled.
+  * @param RTC_HandleTypeDef* hrtc initialized RTC, its alarm interrupt has to be enabled
+  * @param void (*stop_enter)() called before entering Stop mode, may be NULL
+  * @param void (*stop_exit)() called after leaving Stop mode
+  * @retval None
+  */
+void power_init(RTC_HandleTypeDef* hrtc, void (*stop_enter)(), void (*stop_exit)()) {
+	power_hrtc = hrtc;
+	power_stop_enter = stop_enter;
+	power_stop_exit = stop_exit;
+	rtc_steps = hrtc->Init.SynchPrediv + 1;
+	rtc_step_us = 1000000 / rtc_steps;
+	window_start = HAL_GetTick();
+}
+
+/**
+  * @brief Returns the time within the current minute in RTC subseconds. Reading
+  * 	   the subseconds locks time and date until the date is read.
+  * @retval uint32_t RTC subseconds since the minute started
+  */
+uint32_t rtc_now() {
+	uint32_t ss = power_hrtc->Instance->SSR;
+	uint32_t tr = power_hrtc->Instance->TR;
+	uint32_t seconds;
+
+	(void) power_hrtc->Instance->DR;				// unlocks the shadow registers
+	seconds = ((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10 + (tr & RTC_TR_SU);
+	return seconds * rtc_steps + (rtc_steps - 1 - ss);
+}
+
+/**
+  * @brief Waits for the next interrupt in Sleep mode. The HAL tick is suspended,
+  * 	   so only the timers of the tasks and peripherals wake the core.
+  * @retval uint32_t time slept in us
+  */
+uint32_t enter_sleep() {
+	uint32_t start = scheduler_now_us();
+
+	HAL_SuspendTick();
+	HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+	return scheduler_now_us() - start;
+}
+
+/**
+  * @brief Stops all clocks but LSE until the RTC alarm or an EXTI line wakes
+  * 	   the core. The scheduler time is advanced by the time spent in Stop mode,
+  * 	   as its timer didn't count.
+  * @param uint32_t stop_us time till the next release, the alarm is set to at most this
+  * @retval uint32_t time stopped in us
+  */
+uint32_t enter_stop(uint32_t stop_us) {
+	RTC_AlarmTypeDef alarm = {0};
+	uint32_t steps = stop_us / rtc_step_us;
+	uint32_t start;
+	uint32_t stopped;
+
+	if (steps > rtc_steps - 1) steps = rtc_steps - 1;
+	start = rtc_now();
+
+	alarm.AlarmTime.SubSeconds = (rtc_steps - 1 - start % rtc_steps + rtc_steps - steps) % rtc_steps;
+	alarm.AlarmMask = RTC_ALARMMASK_ALL;
+	alarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_NONE;
+	alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
+	alarm.AlarmDateWeekDay = 1;
+	alarm.Alarm = RTC_ALARM_A;
+	if (HAL_RTC_SetAlarm_IT(power_hrtc, &alarm, RTC_FORMAT_BIN) != HAL_OK) return 0;
+
+	if (power_stop_enter) power_stop_enter();
+	HAL_SuspendTick();
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+	power_stop_exit();
+
+	/* Shadow registers are outdated after Stop mode */
+	__HAL_RTC_WRITEPROTECTION_DISABLE(power_hrtc);
+	HAL_RTC_WaitForSynchro(power_hrtc);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(power_hrtc);
+	stopped = (rtc_now() + 60 * rtc_steps - start) % (60 * rtc_steps) * rtc_step_us;
+
+	/* Alarm is only armed for one idle time, its interrupt isn't needed anymore */
+	HAL_RTC_DeactivateAlarm(power_hrtc, RTC_ALARM_A);
+	__HAL_RTC_ALARM_CLEAR_FLAG(power_hrtc, RTC_FLAG_ALRAF);
+	__HAL_RTC_ALARM_EXTI_CLEAR_FLAG();
+	HAL_NVIC_ClearPendingIRQ(RTC_IRQn);
+
+	scheduler_advance(stopped);
+	return stopped;
+}
+
+/**
+  * @brief Idles till the next release of a task or the next interrupt. Has to be
+  * 	   called by the main loop with interrupts disabled, after checking that
+  * 	   no event is left to handle, and returns with interrupts enabled. An
+  * 	   interrupt pending since the check ends the idle time right away.
+  * 	   Stop mode is only entered with IDLE_STOP, Sleep mode only with IDLE_SLEEP.
+  * 	   Only Stop mode wakes at the next release by the RTC alarm, Sleep mode
+  * 	   is left by the next TIM6 tick, as the keypad scan runs every tick then.
+  * @param uint32_t sleep_us time till the next release of any task, 0 if one is ready
+  * @param uint32_t stop_us time till the next release of the tasks that don't
+  * 		   allow Stop mode to be delayed, 0 if a peripheral is busy
+  * @retval enum Power_mode mode the idle time was spent in
+  */
+enum Power_mode power_idle(uint32_t sleep_us, uint32_t stop_us) {
+	enum Power_mode mode = Power_run;
+	uint32_t us = 0;
+
+	if (sleep_us > 0) {
+#ifdef IDLE_SLEEP
+		mode = Power_sleep;
+#endif
+#ifdef IDLE_STOP
+		if (stop_us >= POWER_STOP_MIN_US) mode = Power_stop;
+#endif
+	}
+
+	if (mode == Power_sleep) us = enter_sleep();
+	else if (mode == Power_stop) us = enter_stop(stop_us);
+
+	if (mode != Power_run) {
+		/* HAL tick didn't count while idle */
+		tick_rest_us += us;
+		uwTick += tick_rest_us / 1000;
+		tick_rest_us %= 1000;
+		HAL_ResumeTick();
+	}
+	__enable_irq();
+
+	account(mode, us);
+	return mode;
+}
+
+/**
+  * @brief Adds an idle time to the window. When the window is over, duty cycle
+  * 	   and current estimates are computed into power_stats and the next
+  * 	   window is started.
+  * @param enum Power_mode mode mode the idle time was spent in
+  * @param uint32_t us idle time in us
+  * @retval None
+  */
+void account(enum Power_mode mode, uint32_t us) {
+	uint32_t window_ms = HAL_GetTick() - window_start;
+	uint32_t run_us;
+
+	idle_us[mode] += us;
+	idle_entries[mode]++;
+	if (window_ms < POWER_WINDOW) return;
+
+	run_us = window_ms * 1000;
+	run_us = (idle_us[Power_sleep] + idle_us[Power_stop] > run_us ? 0 : run_us - idle_us[Power_sleep] - idle_us[Power_stop]);
+	power_stats.duty_permille = run_us / window_ms;
+	power_stats.sleep_permille = idle_us[Power_sleep] / window_ms;
+	power_stats.stop_permille = idle_us[Power_stop] / window_ms;
+
+	power_stats.current_ua[Power_run] = IDD_RUN_UA;
+	power_stats.current_ua[Power_sleep] = (power_stats.duty_permille * IDD_RUN_UA
+			+ (1000 - power_stats.duty_permille) * IDD_SLEEP_UA) / 1000;
+	power_stats.current_ua[Power_stop] = (power_stats.duty_permille * IDD_RUN_UA
+			+ (1000 - power_stats.duty_permille) * IDD_STOP_UA) / 1000;
+	power_stats.average_ua = (power_stats.duty_permille * IDD_RUN_UA
+			+ power_stats.sleep_permille * IDD_SLEEP_UA
+			+ power_stats.stop_permille * IDD_STOP_UA) / 1000;
+
+	for (uint8_t i = 0; i < Power_modes; i++) {
+		power_stats.entries[i] = idle_entries[i];
+		idle_us[i] = 0;
+		idle_entries[i] = 0;
+	}
+	window_start += window_ms;
+}
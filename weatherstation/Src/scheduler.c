@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * @file           : scheduler.c
+  * @brief          : Implements a run to completion scheduler for periodic tasks
+  ******************************************************************************
+  *
+  * @author			: Felix Lohse & Arne Bruhns
+  *
+  *
+  ******************************************************************************
+  */
+
+#include "scheduler.h"
+
+/* Task_state holds what the scheduler tracks per task ------------------------*/
+struct Task_state
+{
+	uint32_t next;				// tick of the next release
+	uint32_t release;			// tick of the release waiting to be done
+	uint8_t pending;			// TRUE if released and not done yet
+	uint8_t started;			// TRUE if run at least once since the release
+};
+
+/* Statistics of all tasks ----------------------------------------------------*/
+struct Task_stats task_stats[SCHEDULER_MAX_TASKS];
+
+/*
+ * Task table given to scheduler_init() and the state of its tasks.
+ * scheduler_ticks is the only variable written by the timer interrupt.
+ */
+const struct Task* task_table = NULL;
+struct Task_state task_states[SCHEDULER_MAX_TASKS];
+uint8_t task_count = 0;
+TIM_HandleTypeDef* scheduler_htim = NULL;
+volatile uint32_t scheduler_ticks = 0;
+uint32_t tick_us = 0;						// length of a tick in us
+uint32_t count_us = 0;						// length of a timer count in us
+uint32_t advance_rest_us = 0;				// part of scheduler_advance() time shorter than a tick
+
+/* Private prototypes --------------------------------------------------------*/
+uint16_t auto_phase(const struct Task* table, uint8_t count, uint8_t index);
+uint8_t jitter_bucket(uint32_t latency_us);
+
+/**
+  * @brief Returns the phase of a PHASE_AUTO task. All PHASE_AUTO tasks with the
+  * 	   same period are spread evenly over the period, in table order, so their
+  * 	   releases don't fall on the same tick. Without SCHEDULER_STAGGER all get phase 0.
+  * @param const struct Task* table task table
+  * @param uint8_t count number of tasks
+  * @param uint8_t index task to get the phase for
+  * @retval uint16_t phase in ticks
+  */
+uint16_t auto_phase(const struct Task* table, uint8_t count, uint8_t index) {
+#ifdef SCHEDULER_STAGGER
+	uint8_t before = 0;							// PHASE_AUTO tasks with the same period before index
+	uint8_t same = 0;							// all PHASE_AUTO tasks with the same period
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (table[i].phase != PHASE_AUTO || table[i].period != table[index].period) continue;
+		if (i < index) before++;
+		same++;
+	}
+	return (uint32_t) table[index].period * before / same;
+#else
+	return 0;
+#endif
+}
+
+/**
+  * @brief Sets the task table and releases the first jobs of each task after its phase.
+  * 	   Ticks before the call don't count, so it's called right before the main loop.
+  * 	   The timer has to be running with a period of whole us per count, its period
+  * 	   elapsed callback has to call scheduler_tick().
+  * @param TIM_HandleTypeDef* htim timer counting the ticks
+  * @param const struct Task* table task table, has to stay valid
+  * @param uint8_t count number of tasks, at most SCHEDULER_MAX_TASKS
+  * @retval None
+  */
+void scheduler_init(TIM_HandleTypeDef* htim, const struct Task* table, uint8_t count) {
+	uint32_t now = scheduler_ticks;
+
+	scheduler_htim = htim;
+	count_us = (htim->Init.Prescaler + 1) / (SystemCoreClock / 1000000);
+	tick_us = (htim->Init.Period + 1) * count_us;
+	task_table = table;
+	task_count = (count > SCHEDULER_MAX_TASKS ? SCHEDULER_MAX_TASKS : count);
+	for (uint8_t i = 0; i < task_count; i++) {
+		uint16_t phase = table[i].phase;
+		if (phase == PHASE_AUTO) phase = auto_phase(table, task_count, i);
+		task_states[i].next = now + phase;
+		task_states[i].pending = FALSE;
+	}
+	scheduler_reset_stats();
+}
+
+/**
+  * @brief Has to be called by the period elapsed callback of the timer given
+  * 	   to scheduler_init(). Only advances the time. Called in interrupt context.
+  * @retval None
+  */
+void scheduler_tick() {
+	scheduler_ticks++;
+}
+
+/**
+  * @brief Returns the time since the timer was started in us, from the ticks
+  * 	   and the counter of the running tick. A tick which is pending but not
+  * 	   yet counted by scheduler_tick() (e.g. with interrupts disabled) is
+  * 	   taken into account. Wraps after ~71 minutes.
+  * @retval uint32_t current time in us, 0 before scheduler_init()
+  */
+uint32_t scheduler_now_us() {
+	uint32_t ticks;
+	uint32_t count;
+	uint32_t pending;
+
+	if (scheduler_htim == NULL) return 0;
+	do {
+		ticks = scheduler_ticks;
+		count = __HAL_TIM_GET_COUNTER(scheduler_htim);
+		pending = __HAL_TIM_GET_FLAG(scheduler_htim, TIM_FLAG_UPDATE);
+	} while (ticks != scheduler_ticks);
+
+	if (pending && count < scheduler_htim->Init.Period / 2) ticks++;	// period elapsed, tick not counted yet
+	return ticks * tick_us + count * count_us;
+}
+
+/**
+  * @brief Returns the time till the next release, for the main loop to idle.
+  * 	   Tasks with a period shorter than min_period are left out, e.g. the
+  * 	   keypad scan while the keypad is parked to wake by EXTI.
+  * @param uint16_t min_period shortest period in ticks of the tasks waited for, 0 for all
+  * @retval uint32_t time in us, 0 if a task is pending or due
+  */
+uint32_t scheduler_idle_us(uint16_t min_period) {
+	uint32_t now = scheduler_now_us();
+	uint32_t idle = 0xFFFFFFFF;
+
+	for (uint8_t i = 0; i < task_count; i++) {
+		int32_t time_us;
+
+		if (task_states[i].pending) return 0;
+		if (task_table[i].period < min_period) continue;
+		time_us = task_states[i].next * tick_us - now;
+		if (time_us <= 0) return 0;
+		if ((uint32_t) time_us < idle) idle = time_us;
+	}
+	return idle;
+}
+
+/**
+  * @brief Advances the time after the timer was stopped, e.g. in Stop mode.
+  * 	   Releases missed in between are served by one release right away, like
+  * 	   an overrun but without counting it. Has to be called with interrupts
+  * 	   disabled.
+  * @param uint32_t us time the timer was stopped in us
+  * @retval None
+  */
+void scheduler_advance(uint32_t us) {
+	uint32_t now;
+
+	advance_rest_us += us;
+	scheduler_ticks += advance_rest_us / tick_us;
+	advance_rest_us %= tick_us;
+	now = scheduler_ticks;
+
+	for (uint8_t i = 0; i < task_count; i++) {
+		uint32_t late = now - task_states[i].next;
+
+		if ((int32_t) late > 0) task_states[i].next += late / task_table[i].period * task_table[i].period;
+	}
+}
+
+/**
+  * @brief Releases all tasks whose release tick has come and runs the pending
+  * 	   ones once, in table order. Has to be called by the main loop. A task
+  * 	   released again before it was done counts an overrun, both releases are
+  * 	   served by one run then. Latency and response are measured from the
+  * 	   release tick of the oldest release.
+  * @retval None
+  */
+void scheduler_run() {
+	uint32_t now = scheduler_ticks;
+
+	for (uint8_t i = 0; i < task_count; i++) {
+		const struct Task* task = &task_table[i];
+		struct Task_state* state = &task_states[i];
+		struct Task_stats* stats = &task_stats[i];
+		uint32_t release_us;
+		uint32_t time_us;
+
+		while ((int32_t) (now - state->next) >= 0) {
+			if (state->pending) {
+				stats->overruns++;
+			} else {
+				state->pending = TRUE;
+				state->started = FALSE;
+				state->release = state->next;
+			}
+			state->next += task->period;
+			stats->released++;
+		}
+		if (!state->pending) continue;
+
+		release_us = state->release * tick_us;
+		if (!state->started) {
+			time_us = scheduler_now_us() - release_us;
+			if (time_us > stats->max_latency_us) stats->max_latency_us = time_us;
+			stats->jitter[jitter_bucket(time_us)]++;
+			state->started = TRUE;
+		}
+		if (!task->run()) continue;						// called again by the next scheduler_run()
+
+		state->pending = FALSE;
+		time_us = scheduler_now_us() - release_us;
+		if (time_us > stats->max_response_us) stats->max_response_us = time_us;
+		if (time_us > task->deadline * tick_us) stats->deadline_misses++;
+	}
+}
+
+/**
+  * @brief Releases a task right away in addition to its periodic releases, e.g.
+  * 	   to show a key press without waiting for the next display update. The
+  * 	   task is run by the next scheduler_run(), or by the running one if it
+  * 	   comes later in the table. Does nothing if the task is already pending.
+  * @param uint8_t (*run)() function of the task in the task table
+  * @retval None
+  */
+void scheduler_trigger(uint8_t (*run)()) {
+	for (uint8_t i = 0; i < task_count; i++) {
+		if (task_table[i].run != run || task_states[i].pending) continue;
+		task_states[i].pending = TRUE;
+		task_states[i].started = FALSE;
+		task_states[i].release = scheduler_ticks;
+		task_stats[i].released++;
+	}
+}
+
+/**
+  * @brief Returns the histogram bucket of a latency. Bucket 0 holds latencies
+  * 	   below 128 us, each next bucket twice as wide, the last one all above.
+  * @param uint32_t latency_us time from release to start in us
+  * @retval uint8_t bucket, 0 to JITTER_BUCKETS - 1
+  */
+uint8_t jitter_bucket(uint32_t latency_us) {
+	uint8_t bucket = 0;
+
+	latency_us >>= JITTER_FIRST_SHIFT;
+	while (latency_us && bucket < JITTER_BUCKETS - 1) {
+		latency_us >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+/**
+  * @brief Clears the statistics of all tasks, e.g. after a phase with known
+  * 	   long blocking calls.
+  * @retval None
+  */
+void scheduler_reset_stats() {
+	for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+		task_stats[i].released = 0;
+		task_stats[i].overruns = 0;
+		task_stats[i].deadline_misses = 0;
+		task_stats[i].max_latency_us = 0;
+		task_stats[i].max_response_us = 0;
+		for (uint8_t j = 0; j < JITTER_BUCKETS; j++) task_stats[i].jitter[j] = 0;
+	}
+}